@@ -0,0 +1,217 @@
+#include "ControlServer.h"
+#include "Emulator.h"
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+ControlServer controlServer;
+
+static std::string jsonEscape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + 8);
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    return out;
+}
+
+// Runs one command for a socket session, with everything it prints captured into the reply
+static std::string runCommandAsJson(Session& session, const std::string& line, CommandStatus& status) {
+    std::ostringstream captured;
+    {
+        std::lock_guard<InstrumentedMutex> cmdLock(commandMutex);
+        std::lock_guard<InstrumentedMutex> tickLock(emu().tickMutex);
+        try {
+            status = executeCommand(session, line, captured);
+        }
+        catch (const std::exception& e) {
+            captured << "Error: " << e.what() << "\n";
+            status = CommandStatus::UNKNOWN;
+        }
+    }
+
+    const char* statusStr = status == CommandStatus::OK ? "ok"
+        : status == CommandStatus::EXIT ? "exit" : "unknown";
+    std::string reply = "{\"ok\":";
+    reply += status == CommandStatus::UNKNOWN ? "false" : "true";
+    reply += ",\"status\":\"";
+    reply += statusStr;
+    reply += "\",\"mode\":\"";
+    reply += session.mode == ConsoleMode::MAIN ? "main" : "process";
+    reply += "\",\"process\":\"" + jsonEscape(session.current_process);
+    reply += "\",\"output\":\"" + jsonEscape(captured.str()) + "\"}\n";
+    return reply;
+}
+
+ControlServer::~ControlServer() {
+    stop();
+    reap();
+}
+
+void ControlServer::reap() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        threads.swap(stoppedThreads);
+    }
+    for (auto& t : threads) {
+        if (t.get_id() == std::this_thread::get_id()) t.detach();
+        else t.join();
+    }
+}
+
+#ifdef _WIN32
+
+bool ControlServer::start(const std::string&, std::string& error) {
+    error = "control socket is only supported on POSIX systems";
+    return false;
+}
+void ControlServer::stop() {}
+void ControlServer::acceptLoop(int) {}
+void ControlServer::serveClient(int) {}
+
+#else
+
+bool ControlServer::start(const std::string& socketPath, std::string& error) {
+    if (active.load()) {
+        error = "already listening on " + path;
+        return false;
+    }
+
+    sockaddr_un addr{};
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        error = "socket path too long";
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::copy(socketPath.begin(), socketPath.end(), addr.sun_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = "cannot create socket";
+        return false;
+    }
+    unlink(socketPath.c_str()); // stale socket from a previous run
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        error = "cannot bind " + socketPath;
+        return false;
+    }
+
+    path = socketPath;
+    listenFd = fd;
+    active.store(true);
+    acceptThread = std::thread(&ControlServer::acceptLoop, this, fd);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (!active.exchange(false)) return;
+
+    // Wakes the accept loop, which closes the socket on its way out
+    shutdown(listenFd, SHUT_RDWR);
+    listenFd = -1;
+
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (int fd : clientFds) shutdown(fd, SHUT_RDWR);
+    stoppedThreads.push_back(std::move(acceptThread));
+    for (auto& t : clientThreads) stoppedThreads.push_back(std::move(t));
+    clientThreads.clear();
+    unlink(path.c_str());
+}
+
+void ControlServer::acceptLoop(int fd) {
+    while (true) {
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; // the socket was shut down by stop()
+        }
+        reap(); // threads of clients that have disconnected since the last accept
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        if (!active.load()) {
+            close(client);
+            break;
+        }
+        clientFds.push_back(client);
+        clientThreads.emplace_back(&ControlServer::serveClient, this, client);
+    }
+    close(fd);
+}
+
+static bool sendAll(int fd, const std::string& data) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, flags);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void ControlServer::serveClient(int fd) {
+    static std::atomic<int> nextSessionId{ 1 }; // 0 is the interactive console
+    Session session;
+    session.id = nextSessionId++;
+    std::string pending;
+    char buf[4096];
+    bool open = true;
+
+    while (open) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        pending.append(buf, static_cast<size_t>(n));
+
+        size_t newline;
+        while (open && (newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            CommandStatus status = CommandStatus::OK;
+            std::string reply = runCommandAsJson(session, line, status);
+            // "exit" at the main prompt ends this connection, not the emulator
+            if (!sendAll(fd, reply) || status == CommandStatus::EXIT) open = false;
+        }
+    }
+
+    // Hands this thread to reap(), so a long-lived server does not keep one per connection
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clientFds.erase(std::remove(clientFds.begin(), clientFds.end(), fd), clientFds.end());
+    close(fd);
+    auto self = std::find_if(clientThreads.begin(), clientThreads.end(),
+        [](const std::thread& t) { return t.get_id() == std::this_thread::get_id(); });
+    if (self != clientThreads.end()) { // not already handed over by stop()
+        stoppedThreads.push_back(std::move(*self));
+        clientThreads.erase(self);
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// === Local control socket ===
+// Serves the console command set over a Unix-domain socket for automated drivers.
+// Each connection gets its own Session. Requests are newline-terminated commands;
+// every request gets one JSON line back:
+//   {"ok":true,"status":"ok","mode":"main","process":"","output":"..."}
+class ControlServer {
+public:
+    ~ControlServer();
+
+    bool start(const std::string& path, std::string& error);
+    // Stops listening and disconnects every client without waiting for their threads,
+    // which may be queued on commandMutex behind the caller (control-socket stop)
+    void stop();
+    // Joins the threads of disconnected clients and earlier stops; the accept loop calls it
+    // on every connection. Call without holding commandMutex.
+    void reap();
+    bool running() const { return active.load(); }
+    const std::string& socketPath() const { return path; }
+
+private:
+    void acceptLoop(int fd);
+    void serveClient(int fd);
+
+    std::string path;
+    int listenFd = -1;
+    std::atomic<bool> active{ false };
+    std::thread acceptThread;
+    std::mutex clientsMutex;
+    std::vector<int> clientFds;
+    std::vector<std::thread> clientThreads;
+    std::vector<std::thread> stoppedThreads; // finished clients and stopped threads, for reap()
+};
+
+extern ControlServer controlServer;
@@ -0,0 +1,91 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+
+#include "globals.h"
+#include "LockStats.h"
+#include "MemoryManager.h"
+#include "ProcessGenerator.h"
+#include "Metrics.h"
+#include "Workload.h"
+#include "Replay.h"
+
+// === Emulator instance ===
+// Everything one simulation owns. The command layer, scheduler, instructions and
+// memory manager work on the instance bound to the calling thread (emu()); threads
+// that never bind one use the console's instance. Independent instances can run
+// side by side on different threads, e.g. one per sweep configuration.
+class Emulator {
+public:
+    Emulator();
+    ~Emulator(); // shutdown()
+    Emulator(const Emulator&) = delete;
+    Emulator& operator=(const Emulator&) = delete;
+
+    // Stops the scheduler thread and the process generator, then closes any recording
+    void shutdown();
+
+    // Live processes in slot order, then finished ones; f takes a Process and a
+    // FinishedProcess alike (a generic lambda). The caller holds processTableMutex.
+    template <typename F>
+    void forEachProcess(F&& f) const {
+        for (const Process& p : processTable) f(p);
+        for (const FinishedProcess& p : finishedProcesses) f(p);
+    }
+
+    InstrumentedMutex processTableMutex{ "processTableMutex" };
+    InstrumentedMutex tickMutex{ "tickMutex" }; // held for each tick and each console command, so commands land between ticks
+    bool initialized = false;
+    Config systemConfig;
+    ProcessTable processTable;
+    FinishedProcesses finishedProcesses; // retired from the table, in the order they ended
+    std::vector<CPUCore> cpuCores;
+    int nextPID = 1;
+    unsigned long long global_tick = 0;
+    size_t rrCursor = 0;
+    unsigned long long instructionsExecuted = 0;
+    unsigned long long busyCoreTicks = 0; // core-ticks spent executing an instruction or a bulk transfer
+
+    std::atomic<bool> autoCreateRunning{ false };
+    std::atomic<bool> schedulerRunning{ false };
+    std::thread schedulerThread;
+
+    bool traceEnabled = true;   // false skips trace writes (--no-trace)
+    bool throttleTicks = true;  // false runs ticks back-to-back without the wall-clock delay
+    bool externalTicks = false; // the caller drives ticks (replay); commands never start the scheduler thread
+    bool superinstructions = true; // false dispatches every instruction on its own, e.g. to compare traces
+    std::string tracePath = "csopesy-trace.txt";
+    std::ofstream traceFile; // opened on the first traced instruction
+    std::string backingStorePath = "csopesy-backing-store.txt"; // empty = keep the backing store in memory only
+
+    std::unique_ptr<MemoryManager> memoryManager;
+    MetricsExporter metricsExporter;
+    std::unordered_map<std::string, WorkloadProfile> workloadProfiles;
+    const WorkloadProfile* activeWorkload = nullptr; // nullptr = built-in default pool
+    RunRecorder recorder;
+
+    // Declared last so its worker stops before the state it reads is destroyed
+    ProcessGenerator processGenerator;
+};
+
+// Instance bound to the calling thread, or the console's instance
+Emulator& emu();
+Emulator& consoleEmulator();
+
+// Binds an instance to the current thread for the binding's lifetime
+class EmulatorBinding {
+public:
+    explicit EmulatorBinding(Emulator& instance);
+    ~EmulatorBinding();
+    EmulatorBinding(const EmulatorBinding&) = delete;
+    EmulatorBinding& operator=(const EmulatorBinding&) = delete;
+
+private:
+    Emulator* previous;
+};
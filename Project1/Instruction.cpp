@@ -1,10 +1,15 @@
 #include "Instruction.h"
-#include "globals.h"
+#include "Emulator.h"
+#include "PerfStats.h"
 #include <iostream>
 #include <sstream>
 #include <regex>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 
 // === Utility functions ===
 std::string trim(const std::string& str) {
@@ -47,36 +52,66 @@ std::string unquoteSingle(const std::string& s) {
     return s;
 }
 
+// std::stoi without the exception: false wherever stoi would throw. Most operands are
+// variable names, and a throw per operand dominated building instructions.
+static bool toInt(const std::string& token, int base, int& value) {
+    const char* text = token.c_str();
+    char* end = nullptr;
+    errno = 0;
+    long v = std::strtol(text, &end, base);
+    if (end == text || errno == ERANGE || v < INT_MIN || v > INT_MAX) return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
 // Helper to parse string that might be decimal or hex (0x...)
 int parseAddressOrValue(const std::string& token) {
-    try {
-        return std::stoi(token, nullptr, 0); // 0 base auto-detects 0x
-    } catch (...) {
-        return -1; // Indicator for failure
-    }
+    int value = 0;
+    if (!toInt(token, 0, value)) return -1; // 0 base auto-detects 0x; -1 = failure
+    return value;
+}
+
+Operand Operand::parse(const std::string& token) {
+    Operand op;
+    op.isLiteral = toInt(token, 10, op.literal);
+    if (op.isLiteral) op.text = token;
+    else op.name = internSymbol(token);
+    return op;
+}
+
+std::string Instruction::toString() const {
+    char text[128];
+    TextBuffer out(text, sizeof(text));
+    format(out);
+    if (!out.overflowed()) return std::string(out.view());
+
+    // Long PRINT/FOR bodies: format again into a buffer of the exact size
+    std::string full(out.required(), '\0');
+    TextBuffer retry(full.data(), full.size());
+    format(retry);
+    return full;
 }
 
-// Helper to resolve a token to either an integer or a variable value
-bool getValueFromMemory(Process& p, const std::string& token, int& outVal) {
-    // 1. Try parsing as literal integer
-    try {
-        outVal = std::stoi(token);
-        return true; 
-    } catch (...) {}
+// Helper to resolve an operand to either an integer or a variable value
+bool getValueFromMemory(Process& p, const Operand& operand, int& outVal) {
+    // 1. Literal integer
+    if (operand.isLiteral) {
+        outVal = operand.literal;
+        return true;
+    }
 
     // 2. Look up variable in Symbol Table
-    if (p.symbol_table.find(token) == p.symbol_table.end()) {
+    int addr = p.symbol_table.find(operand.name);
+    if (addr < 0) {
         // Variable not found (runtime error in strict mode, or 0 in loose mode)
         outVal = 0;
         return true;
     }
 
-    int addr = p.symbol_table[token];
-
     // 3. Access Memory (Read)
     // We assume 2-byte integers. We read the address. 
     // (Simplification: we only read 1 word/int at that address)
-    if (!memoryManager->access(p.pid, addr, false, outVal)) {
+    if (!emu().memoryManager->access(p.pid, addr, false, outVal)) {
         return false; // Page Fault triggered
     }
 
@@ -84,28 +119,22 @@ bool getValueFromMemory(Process& p, const std::string& token, int& outVal) {
 }
 
 // Helper to set a variable value in memory
-bool setValueToMemory(Process& p, const std::string& varName, int value) {
-    int addr;
-
-    // 1. Check if variable exists
-    if (p.symbol_table.find(varName) == p.symbol_table.end()) {
-        // Allocate new address in Page 0
-        addr = p.symbol_cursor;
-        p.symbol_table[varName] = addr;
-
-        // === FIX: Increment by 2 bytes (16-bit integer simulation) ===
-        // This ensures variables are stored at 0, 2, 4, etc.
-        p.symbol_cursor += 2;
-    }
-    else {
-        addr = p.symbol_table[varName];
+bool setValueToMemory(Process& p, SymbolId var, int value) {
+    // 1. Find the variable, or allocate the next 2-byte slot in Page 0 (0, 2, 4, ...)
+    int addr = p.symbol_table.declare(var);
+    if (addr < 0) {
+        // The 64-byte symbol table holds 32 variables; one more does not fit in page 0
+        p.logs.emplace_back("Error: symbol table full (" + std::to_string(SymbolTable::CAPACITY) +
+            " variables); " + symbolName(var) + " was not declared");
+        p.setState(ProcessState::MEMORY_VIOLATED);
+        return false;
     }
 
     // 2. Access Memory (Write)
     // We attempt to write to the specific address.
     // Note: logic implies we write to 'addr', and 'addr+1' is effectively "occupied" by this int.
     int temp = value;
-    if (!memoryManager->access(p.pid, addr, true, temp)) {
+    if (!emu().memoryManager->access(p.pid, addr, true, temp)) {
         return false; // Page Fault triggered
     }
 
@@ -113,161 +142,503 @@ bool setValueToMemory(Process& p, const std::string& varName, int value) {
 }
 
 // Helper to clamp uint16
-int clampUint16(int val) {
+int clampUint16(long long val) {
     if (val < 0) return 0;
     if (val > 65535) return 65535;
-    return val;
+    return static_cast<int>(val);
 }
 
 // === Implementations ===
 
-DeclareInstruction::DeclareInstruction(const std::string& v, int value) : var(v), val(value) {}
+DeclareInstruction::DeclareInstruction(const std::string& v, int value)
+    : Instruction(Opcode::DECLARE), var(internSymbol(v)), val(value) {}
 void DeclareInstruction::execute(Process& p) {
     if (setValueToMemory(p, var, clampUint16(val))) {
         p.pc++;
     }
 }
-std::string DeclareInstruction::toString() const {
-    return "DECLARE(" + var + ", " + std::to_string(val) + ")";
+void DeclareInstruction::format(TextBuffer& out) const {
+    out.append("DECLARE(");
+    out.append(symbolName(var));
+    out.append(", ");
+    out.appendInt(val);
+    out.append(')');
 }
 
 AddInstruction::AddInstruction(const std::string& t, const std::string& o1, const std::string& o2)
-    : target(t), op1(o1), op2(o2) {}
+    : Instruction(Opcode::ADD), target(internSymbol(t)), a(Operand::parse(o1)), b(Operand::parse(o2)) {}
 void AddInstruction::execute(Process& p) {
     int v1, v2;
-    if (!getValueFromMemory(p, op1, v1)) return;
-    if (!getValueFromMemory(p, op2, v2)) return; 
+    if (!getValueFromMemory(p, a, v1)) return;
+    if (!getValueFromMemory(p, b, v2)) return; 
     int result = clampUint16(v1 + v2);
     if (setValueToMemory(p, target, result)) {
         p.pc++;
     }
 }
-std::string AddInstruction::toString() const {
-    return "ADD(" + target + ", " + op1 + ", " + op2 + ")";
+void AddInstruction::format(TextBuffer& out) const {
+    out.append("ADD(");
+    out.append(symbolName(target));
+    out.append(", ");
+    out.append(a.token());
+    out.append(", ");
+    out.append(b.token());
+    out.append(')');
 }
 
 SubtractInstruction::SubtractInstruction(const std::string& t, const std::string& o1, const std::string& o2)
-    : target(t), op1(o1), op2(o2) {}
+    : Instruction(Opcode::SUBTRACT), target(internSymbol(t)), a(Operand::parse(o1)), b(Operand::parse(o2)) {}
 void SubtractInstruction::execute(Process& p) {
     int v1, v2;
-    if (!getValueFromMemory(p, op1, v1)) return;
-    if (!getValueFromMemory(p, op2, v2)) return;
+    if (!getValueFromMemory(p, a, v1)) return;
+    if (!getValueFromMemory(p, b, v2)) return;
     int result = clampUint16(v1 - v2);
     if (setValueToMemory(p, target, result)) {
         p.pc++;
     }
 }
-std::string SubtractInstruction::toString() const {
-    return "SUBTRACT(" + target + ", " + op1 + ", " + op2 + ")";
+void SubtractInstruction::format(TextBuffer& out) const {
+    out.append("SUBTRACT(");
+    out.append(symbolName(target));
+    out.append(", ");
+    out.append(a.token());
+    out.append(", ");
+    out.append(b.token());
+    out.append(')');
 }
 
-PrintInstruction::PrintInstruction(const std::string& expr) : expression(expr) {}
+PrintInstruction::PrintInstruction(const std::string& expr) : Instruction(Opcode::PRINT), expression(expr) {
+    for (const auto& piece : splitPrintExpr(expression)) {
+        Part part;
+        part.isText = isSingleQuoted(piece);
+        if (part.isText) part.text = unquoteSingle(piece);
+        else part.value = Operand::parse(piece);
+        parts.push_back(std::move(part));
+    }
+}
 void PrintInstruction::execute(Process& p) {
-    std::vector<std::string> parts = splitPrintExpr(expression);
-    std::ostringstream out;
+    // Built straight in the log's allocator, so a PRINT takes no heap allocation
+    std::pmr::string out(p.logs.get_allocator());
     bool stall = false;
 
-    for (auto& part : parts) {
-        if (isSingleQuoted(part)) {
-            out << unquoteSingle(part);
+    for (const auto& part : parts) {
+        if (part.isText) {
+            out += part.text;
         }
         else {
             int val;
-            if (!getValueFromMemory(p, part, val)) {
+            if (!getValueFromMemory(p, part.value, val)) {
                 stall = true;
                 break; 
             }
-            out << val;
+            char digits[12];
+            out.append(digits, std::to_chars(digits, digits + sizeof(digits), val).ptr);
         }
     }
 
     if (stall) return; 
 
-    p.logs.push_back(out.str());
+    p.logs.push_back(std::move(out));
     p.pc++;
 }
-std::string PrintInstruction::toString() const {
-    return "PRINT(" + expression + ")";
+void PrintInstruction::format(TextBuffer& out) const {
+    out.append("PRINT(");
+    out.append(expression);
+    out.append(')');
 }
 
-SleepInstruction::SleepInstruction(int d) : duration(d) {}
+SleepInstruction::SleepInstruction(int d) : Instruction(Opcode::SLEEP), duration(d) {}
 void SleepInstruction::execute(Process& p) {
-    p.sleep_counter = duration;
-    p.state = ProcessState::SLEEPING;
+    p.setSleepCounter(duration);
+    p.setState(ProcessState::SLEEPING);
     p.pc++;
 }
-std::string SleepInstruction::toString() const {
-    return "SLEEP(" + std::to_string(duration) + ")";
+void SleepInstruction::format(TextBuffer& out) const {
+    out.append("SLEEP(");
+    out.appendInt(duration);
+    out.append(')');
 }
 
-ForInstruction::ForInstruction(const std::string& b, int r) : body(b), repeats(r) {}
-void ForInstruction::execute(Process& p) {
-    std::vector<std::shared_ptr<Instruction>> expanded;
+ForInstruction::ForInstruction(const std::string& b, int r) : Instruction(Opcode::FOR), body(b), repeats(r) {
     std::stringstream ss(body);
     std::string temp;
     while (std::getline(ss, temp, ';')) {
         auto inst = parseInstruction(temp);
         if (inst) expanded.push_back(inst);
     }
-
-    std::vector<std::shared_ptr<Instruction>> fullExpansion;
-    for (int i = 0; i < repeats; ++i) {
-        for (const auto& inst : expanded) {
-            fullExpansion.push_back(inst);
-        }
-    }
-
-    if (p.pc < p.instructions.size()) {
-        auto it = p.instructions.begin() + p.pc;
-        it = p.instructions.erase(it);
-        p.instructions.insert(it, fullExpansion.begin(), fullExpansion.end());
+}
+ForInstruction::ForInstruction(const std::string& b, int r, std::vector<std::shared_ptr<Instruction>> parsedBody)
+    : Instruction(Opcode::FOR), body(b), repeats(r), expanded(std::move(parsedBody)) {}
+void ForInstruction::execute(Process& p) {
+    // Images are immutable: move to the one with this loop expanded, shared by every
+    // process that reaches the same FOR in the same image
+    if (p.pc < p.program->size()) {
+        p.program = p.program->expandLoop(p.pc);
     }
 }
-std::string ForInstruction::toString() const {
-    return "FOR([" + body + "], " + std::to_string(repeats) + ")";
+void ForInstruction::format(TextBuffer& out) const {
+    out.append("FOR([");
+    out.append(body);
+    out.append("], ");
+    out.appendInt(repeats);
+    out.append(')');
 }
 
-WriteInstruction::WriteInstruction(const std::string& a, const std::string& v) : addrStr(a), valStr(v) {}
+WriteInstruction::WriteInstruction(const std::string& a, const std::string& v)
+    : Instruction(Opcode::WRITE), addrText(a), addr(parseAddressOrValue(a)), value(Operand::parse(v)) {}
 void WriteInstruction::execute(Process& p) {
-    int addr = parseAddressOrValue(addrStr);
-    
     int valToWrite;
-    if (!getValueFromMemory(p, valStr, valToWrite)) return; 
+    if (!getValueFromMemory(p, value, valToWrite)) return; 
 
     valToWrite = clampUint16(valToWrite);
 
     if (addr < 0 || addr >= p.memory_required) {
-        p.state = ProcessState::MEMORY_VIOLATED;
+        p.setState(ProcessState::MEMORY_VIOLATED);
         return;
     }
 
     int dummy = valToWrite;
-    if (memoryManager->access(p.pid, addr, true, dummy)) {
+    if (emu().memoryManager->access(p.pid, addr, true, dummy)) {
         p.pc++;
     }
 }
-std::string WriteInstruction::toString() const {
-    return "WRITE(" + addrStr + ", " + valStr + ")";
+void WriteInstruction::format(TextBuffer& out) const {
+    out.append("WRITE(");
+    out.append(addrText);
+    out.append(", ");
+    out.append(value.token());
+    out.append(')');
 }
 
-ReadInstruction::ReadInstruction(const std::string& a, const std::string& v) : addrStr(a), var(v) {}
+ReadInstruction::ReadInstruction(const std::string& a, const std::string& v)
+    : Instruction(Opcode::READ), addrText(a), addr(parseAddressOrValue(a)), var(internSymbol(v)) {}
 void ReadInstruction::execute(Process& p) {
-    int addr = parseAddressOrValue(addrStr);
-    
     if (addr < 0 || addr >= p.memory_required) {
-        p.state = ProcessState::MEMORY_VIOLATED;
+        p.setState(ProcessState::MEMORY_VIOLATED);
         return;
     }
 
     int memVal;
-    if (!memoryManager->access(p.pid, addr, false, memVal)) return; 
+    if (!emu().memoryManager->access(p.pid, addr, false, memVal)) return; 
 
     if (setValueToMemory(p, var, clampUint16(memVal))) {
         p.pc++;
     }
 }
-std::string ReadInstruction::toString() const {
-    return "READ(" + var + ", " + addrStr + ")";
+void ReadInstruction::format(TextBuffer& out) const {
+    out.append("READ(");
+    out.append(symbolName(var));
+    out.append(", ");
+    out.append(addrText);
+    out.append(')');
+}
+
+NopInstruction::NopInstruction() : Instruction(Opcode::NOP) {}
+void NopInstruction::execute(Process& p) {
+    p.pc++;
+}
+void NopInstruction::format(TextBuffer& out) const {
+    out.append("NOP");
+}
+
+// Charges a finished bulk transfer: its own tick counts toward the cost, and the process
+// owes the rest as busy ticks on its core, paid before its next instruction (runSlice)
+static void chargeBulkTransfer(Process& p, int pages) {
+    const long long cost = static_cast<long long>(pages) * emu().systemConfig.bulk_page_ticks;
+    if (cost <= 1) return;
+    p.busy_ticks = static_cast<int>(std::min<long long>(cost - 1, INT_MAX));
+}
+
+// False (and a memory violation) unless [addr, addr + length) lies inside the process
+static bool checkBulkRange(Process& p, int addr, int length) {
+    if (addr < 0 || length < 0 || static_cast<long long>(addr) + length > p.memory_required) {
+        p.setState(ProcessState::MEMORY_VIOLATED);
+        return false;
+    }
+    return true;
+}
+
+MemsetInstruction::MemsetInstruction(const std::string& a, const std::string& v, const std::string& n)
+    : Instruction(Opcode::MEMSET), addrText(a), lengthText(n),
+      addr(parseAddressOrValue(a)), length(parseAddressOrValue(n)), value(Operand::parse(v)) {}
+void MemsetInstruction::execute(Process& p) {
+    int valToWrite;
+    if (!getValueFromMemory(p, value, valToWrite)) return;
+    if (!checkBulkRange(p, addr, length)) return;
+
+    int pages = emu().memoryManager->fill(p.pid, addr, length, clampUint16(valToWrite));
+    if (pages < 0) return;
+    p.pc++;
+    chargeBulkTransfer(p, pages);
+}
+void MemsetInstruction::format(TextBuffer& out) const {
+    out.append("MEMSET(");
+    out.append(addrText);
+    out.append(", ");
+    out.append(value.token());
+    out.append(", ");
+    out.append(lengthText);
+    out.append(')');
+}
+
+MemcpyInstruction::MemcpyInstruction(const std::string& d, const std::string& s, const std::string& n)
+    : Instruction(Opcode::MEMCPY), dstText(d), srcText(s), lengthText(n),
+      dst(parseAddressOrValue(d)), src(parseAddressOrValue(s)), length(parseAddressOrValue(n)) {}
+void MemcpyInstruction::execute(Process& p) {
+    if (!checkBulkRange(p, dst, length) || !checkBulkRange(p, src, length)) return;
+
+    int pages = emu().memoryManager->copy(p.pid, dst, src, length);
+    if (pages < 0) return;
+    p.pc++;
+    chargeBulkTransfer(p, pages);
+}
+void MemcpyInstruction::format(TextBuffer& out) const {
+    out.append("MEMCPY(");
+    out.append(dstText);
+    out.append(", ");
+    out.append(srcText);
+    out.append(", ");
+    out.append(lengthText);
+    out.append(')');
+}
+
+// === Quantum interpreter ===
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CSOPESY_THREADED_DISPATCH // labels as values
+#endif
+
+namespace {
+    // Qualified call: no virtual dispatch, and the body can inline into the loop
+    template <typename T>
+    inline void executeAs(Instruction& instr, Process& p) {
+        PERF_SCOPE(execScope, perfPointFor(instr.opcode()));
+        static_cast<T&>(instr).T::execute(p);
+    }
+
+    bool isMemoryOnly(Opcode op) {
+        return op != Opcode::SLEEP && op != Opcode::FOR && op != Opcode::MEMSET && op != Opcode::MEMCPY;
+    }
+
+    // One part of a superinstruction; false (nothing run) if it is not memory-only
+    inline bool executePart(Instruction& instr, Process& p) {
+        switch (instr.opcode()) {
+        case Opcode::DECLARE: executeAs<DeclareInstruction>(instr, p); return true;
+        case Opcode::ADD: executeAs<AddInstruction>(instr, p); return true;
+        case Opcode::SUBTRACT: executeAs<SubtractInstruction>(instr, p); return true;
+        case Opcode::PRINT: executeAs<PrintInstruction>(instr, p); return true;
+        case Opcode::READ: executeAs<ReadInstruction>(instr, p); return true;
+        case Opcode::WRITE: executeAs<WriteInstruction>(instr, p); return true;
+        case Opcode::NOP: executeAs<NopInstruction>(instr, p); return true;
+        default: return false;
+        }
+    }
+}
+
+std::vector<uint8_t> fuseSuperinstructions(std::span<const std::shared_ptr<Instruction>> program) {
+    std::vector<uint8_t> fused(program.size(), 1);
+    size_t i = 0;
+    while (i < program.size()) {
+        size_t run = 0;
+        while (i + run < program.size() && isMemoryOnly(program[i + run]->opcode())) ++run;
+
+        // Threes, ending on two pairs rather than a three and a leftover single
+        size_t left = run;
+        while (left >= 2) {
+            size_t length = (left == 4) ? 2 : std::min<size_t>(left, 3);
+            fused[i] = static_cast<uint8_t>(length);
+            i += length;
+            left -= length;
+        }
+        if (left == 1) ++i;
+        if (run == 0) ++i;
+    }
+    return fused;
+}
+
+SliceResult runSlice(Process& p, int budget, unsigned long long firstTick) {
+    SliceResult result;
+    const bool trace = emu().traceEnabled;
+    const bool fuse = emu().superinstructions;
+
+    // Next instruction, traced at the tick it runs in; nullptr once the program has ended
+    auto fetch = [&]() -> Instruction* {
+        if (p.pc >= static_cast<int>(p.program->size())) return nullptr;
+        Instruction* next = (*p.program)[p.pc].get();
+        if (trace) logInstructionTrace(p, *next, firstTick + result.ticks());
+        return next;
+    };
+
+    // Spends what is left of the budget on ticks a bulk transfer owes; true if some remain
+    auto payTransfer = [&]() {
+        const int paid = std::min(p.busy_ticks, budget - result.ticks());
+        p.busy_ticks -= paid;
+        result.stalled += paid;
+        return p.busy_ticks > 0;
+    };
+
+    if (budget <= 0 || payTransfer()) return result;
+    Instruction* instr = result.ticks() < budget ? fetch() : nullptr;
+    if (!instr) {
+        if (p.pc >= static_cast<int>(p.program->size())) result.exit = SliceExit::FINISHED;
+        return result;
+    }
+
+#ifdef CSOPESY_THREADED_DISPATCH
+    // Indexed by Opcode; each handler jumps straight to the next instruction's handler
+    static void* const handlers[] = {
+        &&op_DECLARE, &&op_ADD, &&op_SUBTRACT, &&op_PRINT, &&op_SLEEP, &&op_FOR, &&op_READ, &&op_WRITE,
+        &&op_NOP, &&op_MEMSET, &&op_MEMCPY
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(Opcode::COUNT),
+        "one handler per opcode");
+#define DISPATCH() goto *handlers[static_cast<size_t>(instr->opcode())]
+#define HANDLER(op) op_##op
+#else
+#define DISPATCH() goto dispatch
+#define HANDLER(op) case Opcode::op
+#endif
+
+    // Enters a superinstruction when one starts here and at least two ticks are left
+#define DISPATCH_FUSED() \
+    do { \
+        if (fuse && p.program->fusedLength(p.pc) > 1 && budget - result.ticks() > 1) goto superinstruction; \
+        DISPATCH(); \
+    } while (0)
+
+    // Stops on the same conditions, in the same order, as the one-instruction-per-tick
+    // scheduler: end of program, then budget; otherwise moves on to the next instruction
+#define CONTINUE() \
+    do { \
+        if (p.pc >= static_cast<int>(p.program->size())) { result.exit = SliceExit::FINISHED; return result; } \
+        if (result.ticks() == budget) return result; \
+        instr = fetch(); \
+        DISPATCH_FUSED(); \
+    } while (0)
+
+    // Counts the instruction just run
+#define NEXT() \
+    do { \
+        result.executed++; \
+        CONTINUE(); \
+    } while (0)
+
+    // READ/WRITE, and anything storing a variable, leave the pc in place on a
+    // violation, so check before moving on
+#define NEXT_UNLESS_VIOLATED() \
+    do { \
+        if (p.state() == ProcessState::MEMORY_VIOLATED) { \
+            result.executed++; \
+            result.exit = SliceExit::VIOLATION; \
+            return result; \
+        } \
+        NEXT(); \
+    } while (0)
+
+    // MEMSET/MEMCPY then hold the core for the rest of their cost; when the budget runs
+    // out first, the next slice pays the remainder before anything else
+#define NEXT_AFTER_TRANSFER() \
+    do { \
+        if (p.state() != ProcessState::MEMORY_VIOLATED) { \
+            result.executed++; \
+            if (payTransfer()) return result; \
+            CONTINUE(); \
+        } \
+        NEXT_UNLESS_VIOLATED(); \
+    } while (0)
+
+    DISPATCH_FUSED();
+
+superinstruction: {
+        // The parts share one memory-manager batch and skip per-part dispatch, but keep the
+        // per-instruction checks. Marks are only hints: a part that is not memory-only, or
+        // stalls, goes back through normal dispatch.
+        const int length = std::min(p.program->fusedLength(p.pc), budget - result.ticks());
+        bool foreign = false;
+        {
+            MemoryManager::Batch batch(*emu().memoryManager, p.pid);
+            for (int part = 0; part < length; ++part) {
+                const int pcBefore = p.pc;
+                if (!executePart(*instr, p)) {
+                    foreign = true;
+                    break;
+                }
+                result.executed++;
+                if (p.state() == ProcessState::MEMORY_VIOLATED) {
+                    result.exit = SliceExit::VIOLATION;
+                    return result;
+                }
+                if (p.pc >= static_cast<int>(p.program->size())) {
+                    result.exit = SliceExit::FINISHED;
+                    return result;
+                }
+                if (result.ticks() == budget) return result;
+                instr = fetch();
+                if (p.pc == pcBefore) break;
+            }
+        }
+        if (foreign) DISPATCH();
+        DISPATCH_FUSED();
+    }
+
+#ifndef CSOPESY_THREADED_DISPATCH
+dispatch:
+    switch (instr->opcode()) {
+#endif
+    HANDLER(DECLARE):
+        executeAs<DeclareInstruction>(*instr, p);
+        NEXT_UNLESS_VIOLATED();
+    HANDLER(ADD):
+        executeAs<AddInstruction>(*instr, p);
+        NEXT_UNLESS_VIOLATED();
+    HANDLER(SUBTRACT):
+        executeAs<SubtractInstruction>(*instr, p);
+        NEXT_UNLESS_VIOLATED();
+    HANDLER(PRINT):
+        executeAs<PrintInstruction>(*instr, p);
+        NEXT();
+    HANDLER(FOR):
+        {
+            // FOR moves p to another image, which may free this one. Released before
+            // NEXT: a computed goto out of the block would skip the destructor.
+            ProgramRef self = p.program;
+            executeAs<ForInstruction>(*instr, p);
+        }
+        NEXT();
+    HANDLER(READ):
+        executeAs<ReadInstruction>(*instr, p);
+        NEXT_UNLESS_VIOLATED();
+    HANDLER(WRITE):
+        executeAs<WriteInstruction>(*instr, p);
+        NEXT_UNLESS_VIOLATED();
+    HANDLER(NOP):
+        executeAs<NopInstruction>(*instr, p);
+        NEXT();
+    HANDLER(MEMSET):
+        executeAs<MemsetInstruction>(*instr, p);
+        NEXT_AFTER_TRANSFER();
+    HANDLER(MEMCPY):
+        executeAs<MemcpyInstruction>(*instr, p);
+        NEXT_AFTER_TRANSFER();
+    HANDLER(SLEEP):
+        executeAs<SleepInstruction>(*instr, p);
+        result.executed++;
+        result.exit = p.pc >= static_cast<int>(p.program->size()) ? SliceExit::FINISHED : SliceExit::SLEEP;
+        return result;
+#ifndef CSOPESY_THREADED_DISPATCH
+    default:
+        break;
+    }
+#endif
+    return result;
+
+#undef NEXT_AFTER_TRANSFER
+#undef NEXT_UNLESS_VIOLATED
+#undef NEXT
+#undef CONTINUE
+#undef DISPATCH_FUSED
+#undef HANDLER
+#undef DISPATCH
 }
 
 // === Parsing ===
@@ -326,6 +697,23 @@ std::shared_ptr<Instruction> parseInstruction(const std::string& line) {
         return std::make_shared<WriteInstruction>(match[1], match[2]);
     }
 
+    // MEMSET
+    static std::regex memsetRegex(R"(MEMSET\(((?:0x[0-9a-fA-F]+|\d+)),\s*([a-zA-Z0-9_]+),\s*((?:0x[0-9a-fA-F]+|\d+))\))");
+    if (std::regex_match(instr, match, memsetRegex)) {
+        return std::make_shared<MemsetInstruction>(match[1], match[2], match[3]);
+    }
+
+    // MEMCPY
+    static std::regex memcpyRegex(R"(MEMCPY\(((?:0x[0-9a-fA-F]+|\d+)),\s*((?:0x[0-9a-fA-F]+|\d+)),\s*((?:0x[0-9a-fA-F]+|\d+))\))");
+    if (std::regex_match(instr, match, memcpyRegex)) {
+        return std::make_shared<MemcpyInstruction>(match[1], match[2], match[3]);
+    }
+
+    // NOP (left by the optimizer)
+    if (instr == "NOP") {
+        return std::make_shared<NopInstruction>();
+    }
+
     // === Space-Separated Syntax Support ===
 
     // DECLARE <var> <val>
@@ -358,6 +746,18 @@ std::shared_ptr<Instruction> parseInstruction(const std::string& line) {
         return std::make_shared<WriteInstruction>(match[1], match[2]);
     }
 
+    // MEMSET <addr> <val> <length>
+    static std::regex memsetSpaceRegex(R"(MEMSET\s+((?:0x[0-9a-fA-F]+|\d+))\s+([a-zA-Z0-9_]+)\s+((?:0x[0-9a-fA-F]+|\d+)))");
+    if (std::regex_match(instr, match, memsetSpaceRegex)) {
+        return std::make_shared<MemsetInstruction>(match[1], match[2], match[3]);
+    }
+
+    // MEMCPY <dst> <src> <length>
+    static std::regex memcpySpaceRegex(R"(MEMCPY\s+((?:0x[0-9a-fA-F]+|\d+))\s+((?:0x[0-9a-fA-F]+|\d+))\s+((?:0x[0-9a-fA-F]+|\d+)))");
+    if (std::regex_match(instr, match, memcpySpaceRegex)) {
+        return std::make_shared<MemcpyInstruction>(match[1], match[2], match[3]);
+    }
+
     // SLEEP <duration>
     static std::regex sleepSpaceRegex(R"(SLEEP\s+(\d+))");
     if (std::regex_match(instr, match, sleepSpaceRegex)) {
@@ -1,52 +1,115 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <span>
+
+#include "Symbols.h"
+#include "TextBuffer.h"
 
 // Forward declaration
 class Process;
+class Instruction;
+
+// A program being built; processes run it as a shared ProgramImage (see ProgramImage.h)
+using InstructionList = std::vector<std::shared_ptr<Instruction>>;
+
+// Instruction kinds, in the order used by workload profiles and perf reports. NOP is only
+// produced by the optimizer (see Optimizer.h), never generated.
+enum class Opcode { DECLARE, ADD, SUBTRACT, PRINT, SLEEP, FOR, READ, WRITE, NOP, MEMSET, MEMCPY, COUNT };
+
+// A value operand: an integer literal or a variable, resolved once when the instruction
+// is built. Anything std::stoi accepts is a literal; everything else names a variable.
+// Only variables are interned; a literal keeps its text inline, so numbers never grow the
+// process-wide name table and still format back exactly as written.
+struct Operand {
+    bool isLiteral = false;
+    int literal = 0;
+    SymbolId name = 0; // the variable; unused for literals
+    std::string text;  // the literal as written; empty for variables
+
+    static Operand parse(const std::string& token);
+    // The operand as written
+    std::string_view token() const { return isLiteral ? std::string_view(text) : std::string_view(symbolName(name)); }
+};
+
+// Variables hold uint16 values: stores and arithmetic results saturate to [0, 65535]
+int clampUint16(long long val);
 
 // === Instruction Interface ===
 class Instruction {
 public:
     virtual ~Instruction() = default;
     virtual void execute(Process& p) = 0;
-    virtual std::string toString() const = 0;
+    // Writes the source form (parseInstruction accepts it back) without allocating
+    virtual void format(TextBuffer& out) const = 0;
+    Opcode opcode() const { return op; } // stored, so dispatch never goes through the vtable
+
+    std::string toString() const;
+
+protected:
+    explicit Instruction(Opcode op) : op(op) {}
+
+private:
+    Opcode op;
 };
 
 // === Instruction Subclasses ===
 
 class DeclareInstruction : public Instruction {
-    std::string var;
+    SymbolId var;
     int val;
 public:
     DeclareInstruction(const std::string& v, int value);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    SymbolId variable() const { return var; }
+    int value() const { return val; }
 };
 
 class AddInstruction : public Instruction {
-    std::string target, op1, op2;
+    SymbolId target;
+    Operand a, b;
 public:
     AddInstruction(const std::string& t, const std::string& o1, const std::string& o2);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    SymbolId destination() const { return target; }
+    const Operand& lhs() const { return a; }
+    const Operand& rhs() const { return b; }
 };
 
 class SubtractInstruction : public Instruction {
-    std::string target, op1, op2;
+    SymbolId target;
+    Operand a, b;
 public:
     SubtractInstruction(const std::string& t, const std::string& o1, const std::string& o2);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    SymbolId destination() const { return target; }
+    const Operand& lhs() const { return a; }
+    const Operand& rhs() const { return b; }
 };
 
 class PrintInstruction : public Instruction {
-    std::string expression;
 public:
+    // One '+'-separated piece of the expression: quoted text or a value
+    struct Part {
+        bool isText = false;
+        std::string text;
+        Operand value;
+    };
+
     PrintInstruction(const std::string& expr);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    const std::vector<Part>& pieces() const { return parts; }
+    const std::string& text() const { return expression; }
+
+private:
+    std::string expression;
+    std::vector<Part> parts; // split once at construction
 };
 
 class SleepInstruction : public Instruction {
@@ -54,35 +117,127 @@ class SleepInstruction : public Instruction {
 public:
     SleepInstruction(int d);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    int ticks() const { return duration; }
 };
 
 class ForInstruction : public Instruction {
     std::string body;
     int repeats;
+    std::vector<std::shared_ptr<Instruction>> expanded; // body, parsed once at construction
 public:
     ForInstruction(const std::string& b, int r);
+    // With the body already built (e.g. decoded from the program cache) instead of parsed
+    ForInstruction(const std::string& b, int r, std::vector<std::shared_ptr<Instruction>> parsedBody);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    const std::vector<std::shared_ptr<Instruction>>& loopBody() const { return expanded; }
+    const std::string& bodyText() const { return body; }
+    int repeatCount() const { return repeats; }
 };
 
 class WriteInstruction : public Instruction {
-    std::string addrStr;
-    std::string valStr;
+    std::string addrText;
+    int addr;      // -1 if the address text is not a number
+    Operand value;
 public:
     WriteInstruction(const std::string& a, const std::string& v);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    const std::string& addressText() const { return addrText; }
+    int address() const { return addr; }
+    const Operand& source() const { return value; }
 };
 
 class ReadInstruction : public Instruction {
-    std::string addrStr;
-    std::string var;
+    std::string addrText;
+    int addr;      // -1 if the address text is not a number
+    SymbolId var;
 public:
     ReadInstruction(const std::string& a, const std::string& v);
     void execute(Process& p) override;
-    std::string toString() const override;
+    void format(TextBuffer& out) const override;
+    const std::string& addressText() const { return addrText; }
+    int address() const { return addr; }
+    SymbolId variable() const { return var; }
+};
+
+// Takes its tick and does nothing else; stands in for instructions the optimizer
+// removed when tick-accurate timing is kept
+class NopInstruction : public Instruction {
+public:
+    NopInstruction();
+    void execute(Process& p) override;
+    void format(TextBuffer& out) const override;
+};
+
+// === Bulk memory ===
+// MEMSET(dst, value, length) and MEMCPY(dst, src, length) work on [addr, addr + length)
+// page by page through the memory manager (see MemoryManager::fill/copy). A transfer
+// costs "bulk-page-ticks" per page touched; the instruction's own tick counts toward it
+// and the process keeps its core busy for the rest (see chargeBulkTransfer).
+class MemsetInstruction : public Instruction {
+    std::string addrText, lengthText;
+    int addr;      // -1 if the address text is not a number
+    int length;    // -1 if the length text is not a number
+    Operand value;
+public:
+    MemsetInstruction(const std::string& a, const std::string& v, const std::string& n);
+    void execute(Process& p) override;
+    void format(TextBuffer& out) const override;
+    const std::string& addressText() const { return addrText; }
+    const std::string& lengthToken() const { return lengthText; }
+    int address() const { return addr; }
+    int byteCount() const { return length; }
+    const Operand& source() const { return value; }
+};
+
+class MemcpyInstruction : public Instruction {
+    std::string dstText, srcText, lengthText;
+    int dst, src;  // -1 if the address text is not a number
+    int length;    // -1 if the length text is not a number
+public:
+    MemcpyInstruction(const std::string& d, const std::string& s, const std::string& n);
+    void execute(Process& p) override;
+    void format(TextBuffer& out) const override;
+    const std::string& destinationText() const { return dstText; }
+    const std::string& sourceText() const { return srcText; }
+    const std::string& lengthToken() const { return lengthText; }
+    int destination() const { return dst; }
+    int source() const { return src; }
+    int byteCount() const { return length; }
+};
+
+// === Quantum interpreter ===
+// Why runSlice handed the process back to the scheduler
+enum class SliceExit : uint8_t { BUDGET, SLEEP, FINISHED, VIOLATION };
+
+struct SliceResult {
+    int executed = 0; // instructions run, one tick each
+    int stalled = 0;  // ticks spent paying off bulk transfers (Process::busy_ticks)
+    SliceExit exit = SliceExit::BUDGET;
+
+    int ticks() const { return executed + stalled; } // core ticks the slice used
 };
 
+// Runs p from its pc for up to budget ticks in one dispatch loop (threaded code under
+// GCC/Clang, a switch elsewhere), tracing each instruction at firstTick + its offset.
+// Ticks a bulk transfer still owes are paid first, out of the same budget. Stops early
+// when p sleeps, violates memory or runs off the end of its program (with nothing
+// owed); scheduling bookkeeping for the whole slice is left to the caller.
+SliceResult runSlice(Process& p, int budget, unsigned long long firstTick);
+
+// === Superinstructions ===
+// Splits every run of adjacent memory-only instructions (DECLARE, ADD, SUBTRACT, PRINT,
+// READ, WRITE, NOP) into superinstructions of two or three, whatever the opcodes; there
+// is no profile of frequent pairs. runSlice dispatches each one once under one
+// memory-manager batch, so the mutex and process lookup are shared, but every part still
+// translates its own address through access(). Only a slice with two or more ticks left
+// enters one, so this only applies to exec-mode quantum. Returns, per position, the
+// length of the superinstruction starting there (1 = none). Each ProgramImage keeps its
+// own marks, so instructions shared between images are never written. Each part is
+// still traced and charged its own tick, so fusion never shows.
+std::vector<uint8_t> fuseSuperinstructions(std::span<const std::shared_ptr<Instruction>> program);
+
 // === Parsing Function ===
 std::shared_ptr<Instruction> parseInstruction(const std::string& line);
@@ -0,0 +1,81 @@
+#include "LockStats.h"
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+    // Function-local so global mutexes in other translation units can register during static init
+    std::mutex& registryMutex() {
+        static std::mutex m;
+        return m;
+    }
+    std::vector<InstrumentedMutex*>& registry() {
+        static std::vector<InstrumentedMutex*> r;
+        return r;
+    }
+
+    struct Totals {
+        std::string name;
+        uint64_t acquisitions = 0, contended = 0, waitNs = 0, holdNs = 0;
+    };
+}
+
+InstrumentedMutex::InstrumentedMutex(const char* name) : lockName(name) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+}
+
+InstrumentedMutex::~InstrumentedMutex() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto& r = registry();
+    r.erase(std::remove(r.begin(), r.end(), this), r.end());
+}
+
+void resetLockStats() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (auto* m : registry()) {
+        m->acquisitions.store(0, std::memory_order_relaxed);
+        m->contended.store(0, std::memory_order_relaxed);
+        m->waitNs.store(0, std::memory_order_relaxed);
+        m->holdNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::string lockStatReport() {
+    std::vector<Totals> rows;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (auto* m : registry()) {
+            auto it = std::find_if(rows.begin(), rows.end(), [&](const Totals& t) { return t.name == m->name(); });
+            if (it == rows.end()) {
+                rows.push_back({ m->name() });
+                it = rows.end() - 1;
+            }
+            it->acquisitions += m->acquisitions.load(std::memory_order_relaxed);
+            it->contended += m->contended.load(std::memory_order_relaxed);
+            it->waitNs += m->waitNs.load(std::memory_order_relaxed);
+            it->holdNs += m->holdNs.load(std::memory_order_relaxed);
+        }
+    }
+    // Most waited-on lock first: that is the one limiting scaling
+    std::sort(rows.begin(), rows.end(), [](const Totals& a, const Totals& b) { return a.waitNs > b.waitNs; });
+
+    std::ostringstream out;
+    out << std::left << std::setw(20) << "Lock"
+        << std::right << std::setw(12) << "Acquired" << std::setw(12) << "Contended"
+        << std::setw(8) << "Cont%" << std::setw(12) << "Wait(ms)" << std::setw(12) << "Hold(ms)"
+        << std::setw(12) << "AvgHold(ns)" << "\n";
+    out << std::fixed;
+    for (const auto& t : rows) {
+        double pct = t.acquisitions ? 100.0 * t.contended / t.acquisitions : 0.0;
+        uint64_t avgHold = t.acquisitions ? t.holdNs / t.acquisitions : 0;
+        out << std::left << std::setw(20) << t.name
+            << std::right << std::setw(12) << t.acquisitions << std::setw(12) << t.contended
+            << std::setw(7) << std::setprecision(1) << pct << "%"
+            << std::setw(12) << std::setprecision(2) << t.waitNs / 1e6
+            << std::setw(12) << t.holdNs / 1e6
+            << std::setw(12) << avgHold << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// === Instrumented mutex ===
+// Drop-in for std::mutex (works with lock_guard/unique_lock) that counts
+// acquisitions, contended acquisitions, time spent waiting and time held.
+// Every live instance is listed by the lockstat command. CSOPESY_NO_PERF
+// leaves only the plain lock/unlock.
+class InstrumentedMutex {
+public:
+    explicit InstrumentedMutex(const char* name);
+    ~InstrumentedMutex();
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    void lock() {
+#ifdef CSOPESY_NO_PERF
+        m.lock();
+#else
+        if (!m.try_lock()) {
+            auto waitStart = std::chrono::steady_clock::now();
+            m.lock();
+            auto waited = std::chrono::steady_clock::now() - waitStart;
+            contended.fetch_add(1, std::memory_order_relaxed);
+            waitNs.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()), std::memory_order_relaxed);
+        }
+        onAcquired();
+#endif
+    }
+
+    bool try_lock() {
+        if (!m.try_lock()) return false;
+#ifndef CSOPESY_NO_PERF
+        onAcquired();
+#endif
+        return true;
+    }
+
+    void unlock() {
+#ifndef CSOPESY_NO_PERF
+        // heldSince is only touched by the owner, so it is read before the release
+        auto held = std::chrono::steady_clock::now() - heldSince;
+        holdNs.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(held).count()), std::memory_order_relaxed);
+#endif
+        m.unlock();
+    }
+
+    const char* name() const { return lockName; }
+
+    std::atomic<uint64_t> acquisitions{ 0 };
+    std::atomic<uint64_t> contended{ 0 };
+    std::atomic<uint64_t> waitNs{ 0 };
+    std::atomic<uint64_t> holdNs{ 0 };
+
+private:
+    void onAcquired() {
+        heldSince = std::chrono::steady_clock::now();
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::mutex m;
+    const char* lockName;
+    std::chrono::steady_clock::time_point heldSince;
+};
+
+// Table of every live InstrumentedMutex (same-named instances are merged)
+std::string lockStatReport();
+void resetLockStats();
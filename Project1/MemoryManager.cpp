@@ -1,11 +1,13 @@
-#include "globals.h"
+#include "Emulator.h"
 #include "MemoryManager.h"
+#include "PerfStats.h"
+#include "Replay.h"
+#include "Snapshot.h"
 
-// Define the global unique_ptr
-std::unique_ptr<MemoryManager> memoryManager;
+#include <cstring>
 
-MemoryManager::MemoryManager(size_t total_frames, size_t frame_size)
-    : total_frames(total_frames), frame_size(frame_size) {
+MemoryManager::MemoryManager(size_t total_frames, size_t frame_size, const std::string& backing_store_path)
+    : total_frames(total_frames), frame_size(frame_size), backing_store_path(backing_store_path) {
     frame_table.resize(total_frames);
     ram.resize(total_frames * frame_size, 0); // Initialize RAM with 0
 
@@ -16,33 +18,57 @@ MemoryManager::MemoryManager(size_t total_frames, size_t frame_size)
     }
 
     // Clear backing store file on startup
-    std::ofstream ofs("csopesy-backing-store.txt", std::ofstream::out | std::ofstream::trunc);
+    if (backing_store_path.empty()) return;
+    std::ofstream ofs(backing_store_path, std::ofstream::out | std::ofstream::trunc);
     ofs.close();
 }
 
+namespace {
+    thread_local MemoryManager::Batch* openBatch = nullptr; // at most one per thread
+}
+
+MemoryManager::Batch::Batch(MemoryManager& manager, int pid) : manager(manager), pid(pid) {
+    manager.mem_mutex.lock();
+    {
+        std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
+        owner = emu().processTable.find(pid);
+        proc = emu().processTable.get(owner);
+    }
+    openBatch = this;
+}
+
+MemoryManager::Batch::~Batch() {
+    openBatch = nullptr;
+    manager.mem_mutex.unlock();
+}
+
 bool MemoryManager::access(int pid, int virtual_addr, bool write, int& value) {
-    std::lock_guard<std::mutex> lock(mem_mutex);
+    PERF_SCOPE(accessScope, PerfPoint::ACCESS_HIT);
+    const bool batched = openBatch && &openBatch->manager == this; // mem_mutex already held
+    std::unique_lock<InstrumentedMutex> lock(mem_mutex, std::defer_lock);
+    if (!batched) lock.lock();
 
     int page_num = virtual_addr / frame_size;
     int offset = virtual_addr % frame_size;
 
     // Find process securely
+    ProcessHandle owner;
     Process* proc = nullptr;
-    {
-        std::lock_guard<std::mutex> pLock(processTableMutex);
-        for (auto& p : processTable) {
-            if (p.pid == pid) {
-                proc = &p;
-                break;
-            }
-        }
+    if (batched && openBatch->pid == pid) {
+        owner = openBatch->owner;
+        proc = openBatch->proc;
+    }
+    else {
+        std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
+        owner = emu().processTable.find(pid);
+        proc = emu().processTable.get(owner);
     }
 
     if (!proc) return false;
 
     // Check bounds
     if (virtual_addr >= proc->memory_required) {
-        std::cout << "Error: Segmentation Fault (PID " << pid << " Addr " << virtual_addr << ")\n";
+        consoleOut() << "Error: Segmentation Fault (PID " << pid << " Addr " << virtual_addr << ")\n";
         return false;
     }
 
@@ -52,14 +78,15 @@ bool MemoryManager::access(int pid, int virtual_addr, bool write, int& value) {
     }
 
     PageTableEntry& pte = proc->page_table[page_num];
-    pte.last_accessed = global_tick; // Update LRU timestamp
+    pte.last_accessed = emu().global_tick; // Update LRU timestamp
 
     if (!pte.valid) {
+        PERF_RELABEL(accessScope, PerfPoint::ACCESS_FAULT);
         // Page Fault!
         // Release lock momentarily to prevent deadlock if needed, 
         // but here we hold it because handlePageFault is internal.
-        if (!handlePageFault(pid, page_num)) {
-            std::cout << "Error: Failed to handle page fault for PID " << pid << "\n";
+        if (!handlePageFault(owner, pid, page_num)) {
+            consoleOut() << "Error: Failed to handle page fault for PID " << pid << "\n";
             return false;
         }
     }
@@ -78,8 +105,122 @@ bool MemoryManager::access(int pid, int virtual_addr, bool write, int& value) {
     return true;
 }
 
+// === Bulk access ===
+Process* MemoryManager::lookupForBulk(int pid, ProcessHandle& owner) {
+    if (openBatch && &openBatch->manager == this && openBatch->pid == pid) {
+        owner = openBatch->owner;
+        return openBatch->proc;
+    }
+    std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
+    owner = emu().processTable.find(pid);
+    return emu().processTable.get(owner);
+}
+
+// The page's frame in RAM, faulted in first if needed
+int* MemoryManager::residentFrame(ProcessHandle owner, Process& proc, int page_num, bool write) {
+    PageTableEntry& pte = proc.page_table[page_num];
+    pte.last_accessed = emu().global_tick;
+    if (!pte.valid && !handlePageFault(owner, proc.pid, page_num)) {
+        consoleOut() << "Error: Failed to handle page fault for PID " << proc.pid << "\n";
+        return nullptr;
+    }
+    if (write) pte.dirty = true;
+    return ram.data() + static_cast<size_t>(pte.frame_num) * frame_size;
+}
+
+int MemoryManager::pagesSpanned(int addr, int length) const {
+    if (length <= 0) return 0;
+    const int size = static_cast<int>(frame_size);
+    return (addr + length - 1) / size - addr / size + 1;
+}
+
+int MemoryManager::fill(int pid, int virtual_addr, int length, int value) {
+    PERF_SCOPE(bulkScope, PerfPoint::ACCESS_BULK);
+    const bool batched = openBatch && &openBatch->manager == this;
+    std::unique_lock<InstrumentedMutex> lock(mem_mutex, std::defer_lock);
+    if (!batched) lock.lock();
+
+    ProcessHandle owner;
+    Process* proc = lookupForBulk(pid, owner);
+    if (!proc) return -1;
+    if (virtual_addr < 0 || length < 0 || static_cast<long long>(virtual_addr) + length > proc->memory_required) {
+        consoleOut() << "Error: Segmentation Fault (PID " << pid << " Addr " << virtual_addr << ")\n";
+        return -1;
+    }
+
+    const int size = static_cast<int>(frame_size);
+    for (int addr = virtual_addr, end = virtual_addr + length; addr < end;) {
+        const int offset = addr % size;
+        const int n = std::min(size - offset, end - addr);
+        int* frame = residentFrame(owner, *proc, addr / size, true);
+        if (!frame) return -1;
+        std::fill_n(frame + offset, n, value);
+        addr += n;
+    }
+    return pagesSpanned(virtual_addr, length);
+}
+
+// Copies in chunks that stay inside one source and one destination page. Faulting in the
+// destination may evict the source page (or the reverse), so a chunk goes frame to frame
+// only when both are resident together and through a buffer otherwise. Overlapping
+// ranges copy back to front when the destination is above the source, like memmove.
+int MemoryManager::copy(int pid, int dst_addr, int src_addr, int length) {
+    PERF_SCOPE(bulkScope, PerfPoint::ACCESS_BULK);
+    const bool batched = openBatch && &openBatch->manager == this;
+    std::unique_lock<InstrumentedMutex> lock(mem_mutex, std::defer_lock);
+    if (!batched) lock.lock();
+
+    ProcessHandle owner;
+    Process* proc = lookupForBulk(pid, owner);
+    if (!proc) return -1;
+    for (int addr : { dst_addr, src_addr }) {
+        if (addr < 0 || length < 0 || static_cast<long long>(addr) + length > proc->memory_required) {
+            consoleOut() << "Error: Segmentation Fault (PID " << pid << " Addr " << addr << ")\n";
+            return -1;
+        }
+    }
+
+    const int size = static_cast<int>(frame_size);
+    const bool backward = dst_addr > src_addr && dst_addr < src_addr + length;
+    thread_local std::vector<int> bounce;
+    for (int done = 0; done < length;) {
+        const int left = length - done;
+        int src, dst, n;
+        if (!backward) {
+            src = src_addr + done;
+            dst = dst_addr + done;
+            n = std::min({ left, size - src % size, size - dst % size });
+        }
+        else {
+            const int srcEnd = src_addr + left, dstEnd = dst_addr + left;
+            n = std::min({ left, (srcEnd - 1) % size + 1, (dstEnd - 1) % size + 1 });
+            src = srcEnd - n;
+            dst = dstEnd - n;
+        }
+
+        int* from = residentFrame(owner, *proc, src / size, false);
+        if (!from) return -1;
+        const int srcFrame = proc->page_table[src / size].frame_num;
+        int* to = residentFrame(owner, *proc, dst / size, true);
+        if (!to) return -1;
+        const PageTableEntry& srcPte = proc->page_table[src / size];
+        if (srcPte.valid && srcPte.frame_num == srcFrame) {
+            std::memmove(to + dst % size, from + src % size, static_cast<size_t>(n) * sizeof(int));
+        }
+        else {
+            // The source page was evicted to make room: stage it, then fault the destination back
+            if (!(from = residentFrame(owner, *proc, src / size, false))) return -1;
+            bounce.assign(from + src % size, from + src % size + n);
+            if (!(to = residentFrame(owner, *proc, dst / size, true))) return -1;
+            std::copy_n(bounce.data(), n, to + dst % size);
+        }
+        done += n;
+    }
+    return pagesSpanned(dst_addr, length) + pagesSpanned(src_addr, length);
+}
+
 void MemoryManager::initializePageTable(Process& p, int required_pages) {
-    std::lock_guard<std::mutex> lock(mem_mutex);
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
     p.page_table.clear();
     for (int i = 0; i < required_pages; ++i) {
         p.page_table[i] = PageTableEntry();
@@ -87,18 +228,13 @@ void MemoryManager::initializePageTable(Process& p, int required_pages) {
 }
 
 bool MemoryManager::isPageResident(int pid, int virtual_addr) {
-    std::lock_guard<std::mutex> lock(mem_mutex);
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
     
     // Find process securely
     Process* proc = nullptr;
     {
-        std::lock_guard<std::mutex> pLock(processTableMutex);
-        for (auto& p : processTable) {
-            if (p.pid == pid) {
-                proc = &p;
-                break;
-            }
-        }
+        std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
+        proc = emu().processTable.get(emu().processTable.find(pid));
     }
     if (!proc) return false;
 
@@ -111,7 +247,7 @@ bool MemoryManager::isPageResident(int pid, int virtual_addr) {
     return false;
 }
 
-bool MemoryManager::handlePageFault(int pid, int page_num) {
+bool MemoryManager::handlePageFault(ProcessHandle owner, int pid, int page_num) {
     int frame_idx = allocateFrame();
     if (frame_idx == -1) return false;
 
@@ -141,18 +277,16 @@ bool MemoryManager::handlePageFault(int pid, int page_num) {
     frame_table[frame_idx].pid = pid;
     frame_table[frame_idx].page_num = page_num;
     frame_table[frame_idx].occupied = true;
+    frame_table[frame_idx].owner = owner;
 
     // Update Page Table
     {
-        std::lock_guard<std::mutex> pLock(processTableMutex);
-        for (auto& p : processTable) {
-            if (p.pid == pid) {
-                p.page_table[page_num].frame_num = frame_idx;
-                p.page_table[page_num].valid = true;
-                p.page_table[page_num].dirty = false;
-                p.page_table[page_num].last_accessed = global_tick;
-                break;
-            }
+        std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
+        if (Process* p = emu().processTable.get(owner)) {
+            p->page_table[page_num].frame_num = frame_idx;
+            p->page_table[page_num].valid = true;
+            p->page_table[page_num].dirty = false;
+            p->page_table[page_num].last_accessed = emu().global_tick;
         }
     }
 
@@ -172,6 +306,7 @@ int MemoryManager::allocateFrame() {
 }
 
 int MemoryManager::evictVictim() {
+    PERF_SCOPE(evictScope, PerfPoint::EVICT_VICTIM);
     int victim_frame = -1;
     unsigned long long min_tick = -1; // Max value
 
@@ -179,24 +314,20 @@ int MemoryManager::evictVictim() {
     // We need to look up the Process's PageTable to get the 'last_accessed' time
     // because that's where we store it.
 
-    std::lock_guard<std::mutex> pLock(processTableMutex);
+    std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
 
     for (size_t i = 0; i < total_frames; ++i) {
-        int pid = frame_table[i].pid;
-        int page = frame_table[i].page_num;
-
-        // Find process
-        for (auto& p : processTable) {
-            if (p.pid == pid) {
-                if (p.page_table.count(page)) {
-                    unsigned long long last = p.page_table[page].last_accessed;
-                    if (last < min_tick) {
-                        min_tick = last;
-                        victim_frame = static_cast<int>(i);
-                    }
-                }
-                break;
-            }
+        const Process* p = emu().processTable.get(frame_table[i].owner);
+        if (!p) {
+            // Owner was retired; nothing references this frame any more
+            victim_frame = static_cast<int>(i);
+            break;
+        }
+
+        auto it = p->page_table.find(frame_table[i].page_num);
+        if (it != p->page_table.end() && it->second.last_accessed < min_tick) {
+            min_tick = it->second.last_accessed;
+            victim_frame = static_cast<int>(i);
         }
     }
 
@@ -207,37 +338,37 @@ int MemoryManager::evictVictim() {
     int v_pid = frame_table[victim_frame].pid;
     int v_page = frame_table[victim_frame].page_num;
 
-    for (auto& p : processTable) {
-        if (p.pid == v_pid) {
-            PageTableEntry& pte = p.page_table[v_page];
-
-            // Write back if dirty
-            if (pte.dirty) {
-                std::string key = std::to_string(v_pid) + ":" + std::to_string(v_page);
-                std::vector<int> page_data(frame_size);
-                int phys_start = victim_frame * frame_size;
-                for (size_t k = 0; k < frame_size; ++k) {
-                    page_data[k] = ram[phys_start + k];
-                }
-                backing_store[key] = page_data;
-
-                stats.pages_paged_out++;
-                flushBackingStore(); // Persist to disk
+    if (Process* victim = emu().processTable.get(frame_table[victim_frame].owner)) {
+        PageTableEntry& pte = victim->page_table[v_page];
+
+        // Write back if dirty
+        if (pte.dirty) {
+            std::string key = std::to_string(v_pid) + ":" + std::to_string(v_page);
+            std::vector<int> page_data(frame_size);
+            int phys_start = victim_frame * frame_size;
+            for (size_t k = 0; k < frame_size; ++k) {
+                page_data[k] = ram[phys_start + k];
             }
+            backing_store[key] = page_data;
 
-            pte.valid = false;
-            pte.frame_num = -1;
-            pte.dirty = false;
-            break;
+            stats.pages_paged_out++;
+            pte.paged_out = true;
+            flushBackingStore(); // Persist to disk
         }
+
+        pte.valid = false;
+        pte.frame_num = -1;
+        pte.dirty = false;
     }
 
     frame_table[victim_frame].occupied = false;
+    frame_table[victim_frame].owner = ProcessHandle{};
     return victim_frame;
 }
 
 void MemoryManager::flushBackingStore() {
-    std::ofstream outFile("csopesy-backing-store.txt");
+    if (backing_store_path.empty()) return;
+    std::ofstream outFile(backing_store_path);
     for (const auto& [key, data] : backing_store) {
         outFile << "Page: " << key << " Data: ";
         for (int val : data) outFile << val << " ";
@@ -264,4 +395,108 @@ size_t MemoryManager::getUsedMemory() const {
 
 VMStatCounters MemoryManager::getVMStat() {
     return stats;
-}
\ No newline at end of file
+}
+
+void MemoryManager::hashState(StateHasher& h) {
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
+    for (const auto& f : frame_table) {
+        h.add(static_cast<uint64_t>(f.pid));
+        h.add(static_cast<uint64_t>(f.page_num));
+    }
+    for (int v : ram) h.add(static_cast<uint64_t>(v));
+
+    std::vector<const std::pair<const std::string, std::vector<int>>*> pages;
+    for (const auto& entry : backing_store) pages.push_back(&entry);
+    std::sort(pages.begin(), pages.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+    for (const auto* entry : pages) {
+        h.add(entry->first);
+        for (int v : entry->second) h.add(static_cast<uint64_t>(v));
+    }
+    h.add(stats.pages_paged_in);
+    h.add(stats.pages_paged_out);
+}
+
+void MemoryManager::saveState(SnapshotWriter& out) {
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
+    out.u64(total_frames);
+    out.u64(frame_size);
+    for (const auto& f : frame_table) {
+        out.i32(f.pid);
+        out.i32(f.page_num);
+        out.u8(f.occupied ? 1 : 0);
+    }
+    out.raw(ram.data(), ram.size() * sizeof(int));
+
+    out.u32(static_cast<uint32_t>(backing_store.size()));
+    for (const auto& [key, data] : backing_store) {
+        out.str(key);
+        out.u32(static_cast<uint32_t>(data.size()));
+        out.raw(data.data(), data.size() * sizeof(int));
+    }
+    out.u64(stats.pages_paged_in);
+    out.u64(stats.pages_paged_out);
+}
+
+bool MemoryManager::loadState(SnapshotReader& in) {
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
+    if (in.u64() != total_frames || in.u64() != frame_size) return false;
+    for (auto& f : frame_table) {
+        f.pid = in.i32();
+        f.page_num = in.i32();
+        f.occupied = in.u8() != 0;
+    }
+    in.raw(ram.data(), ram.size() * sizeof(int));
+
+    backing_store.clear();
+    uint32_t pages = in.u32();
+    for (uint32_t i = 0; i < pages && in.good(); ++i) {
+        std::string key = in.str();
+        uint32_t n = in.u32();
+        if (!in.fits(n, sizeof(int))) break;
+        std::vector<int> data(n);
+        in.raw(data.data(), n * sizeof(int));
+        backing_store.emplace(std::move(key), std::move(data));
+    }
+    stats.pages_paged_in = in.u64();
+    stats.pages_paged_out = in.u64();
+    if (in.good()) flushBackingStore();
+    return in.good();
+}
+
+void MemoryManager::relinkOwners(const ProcessTable& table) {
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
+    for (auto& frame : frame_table) {
+        frame.owner = frame.occupied ? table.find(frame.pid) : ProcessHandle{};
+    }
+}
+
+bool MemoryManager::retireProcess(ProcessHandle owner, FinishedProcesses& finished) {
+    std::lock_guard<InstrumentedMutex> lock(mem_mutex);
+    bool onDisk = false;
+    {
+        std::lock_guard<InstrumentedMutex> pLock(emu().processTableMutex);
+        Process* p = emu().processTable.get(owner);
+        if (!p) return false;
+
+        // Every page the process touched has a page-table entry and a "pid:page" key
+        std::string key = std::to_string(p->pid) + ":";
+        const size_t prefixLength = key.size();
+        for (const auto& [page, pte] : p->page_table) {
+            if (pte.valid && pte.frame_num >= 0 && frame_table[pte.frame_num].owner == owner) {
+                frame_table[pte.frame_num] = FrameTableEntry{};
+            }
+            key.resize(prefixLength);
+            key += std::to_string(page);
+            if (backing_store.erase(key) > 0 && pte.paged_out) onDisk = true;
+        }
+
+        p->page_table.clear();
+        finished.push_back(FinishedProcess(std::move(*p))); // name and logs move; the page table goes back to the pool
+        emu().processTable.erase(owner);
+    }
+
+    // Pages only ever faulted in were never written by this process; they leave the file
+    // with its next rewrite
+    if (onDisk) flushBackingStore();
+    return true;
+}
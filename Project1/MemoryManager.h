@@ -8,8 +8,16 @@
 #include <deque>
 #include <string>
 
+#include "LockStats.h"
+#include "ProcessHandle.h"
+
 // Forward declaration
 class Process;
+class ProcessTable;
+class FinishedProcesses;
+class StateHasher;
+class SnapshotWriter;
+class SnapshotReader;
 
 // Global VMStat Counters
 struct VMStatCounters {
@@ -21,6 +29,7 @@ struct PageTableEntry {
     int frame_num = -1;
     bool valid = false;
     bool dirty = false;
+    bool paged_out = false; // written back to the backing store at least once
     unsigned long long last_accessed = 0; // For LRU
 };
 
@@ -28,15 +37,40 @@ struct FrameTableEntry {
     int pid = -1;
     int page_num = -1;
     bool occupied = false;
+    ProcessHandle owner; // resolves to nothing once the owner is retired
 };
 
 class MemoryManager {
 public:
-    MemoryManager(size_t total_frames, size_t frame_size);
+    // backing_store_path: file mirroring the backing store (empty = memory only)
+    MemoryManager(size_t total_frames, size_t frame_size, const std::string& backing_store_path = "csopesy-backing-store.txt");
 
     // Returns true if access successful (or page fault handled), false if error
     bool access(int pid, int virtual_addr, bool write, int& value);
 
+    // Holds mem_mutex and one process lookup across several accesses, e.g. the parts of a
+    // superinstruction; access() calls on the same thread reuse both while it is open
+    class Batch {
+    public:
+        Batch(MemoryManager& manager, int pid);
+        ~Batch();
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    private:
+        friend class MemoryManager;
+        MemoryManager& manager;
+        int pid;
+        ProcessHandle owner;
+        Process* proc = nullptr;
+    };
+
+    // MEMSET/MEMCPY over [addr, addr + length), page by page: each page is faulted in once
+    // and its part of the frame filled or copied as one contiguous block. Return the pages
+    // spanned (source plus destination for a copy), or -1 on an error like access().
+    int fill(int pid, int virtual_addr, int length, int value);
+    int copy(int pid, int dst_addr, int src_addr, int length);
+
     // Allocate frames for a process (called on process creation)
     void initializePageTable(Process& p, int required_pages);
 
@@ -51,6 +85,23 @@ public:
     // VMStat Helpers
     VMStatCounters getVMStat();
 
+    // Feeds frames, RAM, backing store and counters into a replay digest
+    void hashState(StateHasher& h);
+
+    // Checkpoint/restore of frames, RAM, backing store and counters; load fails on a size mismatch
+    void saveState(SnapshotWriter& out);
+    bool loadState(SnapshotReader& in);
+    // Re-resolves frame owners by pid after the process table was rebuilt
+    void relinkOwners(const ProcessTable& table);
+
+    // Moves an ended process from the table to the back of finished (with an empty page
+    // table), frees its frames and drops its backing-store pages. Only the process's own
+    // page table is walked, and the backing-store file is rewritten only if one of the
+    // dropped pages had been paged out to it. Processes leave the table only here and
+    // under mem_mutex, so a Process* looked up while holding mem_mutex (access, fill,
+    // copy, a Batch) stays valid until the lock is released.
+    bool retireProcess(ProcessHandle owner, FinishedProcesses& finished);
+
     // Backing store simulation
     // Key: "pid:page_num", Value: vector<int> (size = frame_size)
     std::unordered_map<std::string, std::vector<int>> backing_store;
@@ -58,15 +109,21 @@ public:
 private:
     size_t total_frames;
     size_t frame_size;
+    std::string backing_store_path;
     std::vector<FrameTableEntry> frame_table;
     std::vector<int> ram; // Physical memory: size = total_frames * frame_size
-    std::mutex mem_mutex;
+    InstrumentedMutex mem_mutex{ "mem_mutex" };
 
     // VMStat internal counters
     VMStatCounters stats;
 
     // Helper to handle page fault
-    bool handlePageFault(int pid, int page_num);
+    bool handlePageFault(ProcessHandle owner, int pid, int page_num);
+
+    // Bulk-access helpers; the caller holds mem_mutex
+    Process* lookupForBulk(int pid, ProcessHandle& owner);
+    int* residentFrame(ProcessHandle owner, Process& proc, int page_num, bool write);
+    int pagesSpanned(int addr, int length) const;
 
     // Helper to find a free frame or evict a victim
     int allocateFrame();
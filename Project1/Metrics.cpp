@@ -0,0 +1,120 @@
+#include "Metrics.h"
+#include "Emulator.h"
+#include <filesystem>
+#include <iomanip>
+
+void MetricsExporter::configure(unsigned long long interval, const std::string& csvPath, const std::string& promPath) {
+    this->interval = interval;
+    this->csvPath = csvPath;
+    this->promPath = promPath;
+    lastTick = emu().global_tick;
+    lastPagedIn = lastPagedOut = 0;
+    lastWall = std::chrono::steady_clock::now();
+
+    if (csv.is_open()) csv.close();
+    if (!enabled() || csvPath.empty()) return;
+
+    std::error_code ec;
+    bool fresh = !std::filesystem::exists(csvPath, ec) || std::filesystem::file_size(csvPath, ec) == 0;
+    csv.open(csvPath, std::ios::app);
+    if (!csv.is_open()) {
+        consoleOut() << "Warning: cannot open metrics file " << csvPath << "\n";
+        return;
+    }
+    if (fresh) {
+        csv << "tick,utilization,ready,running,sleeping,finished,memory_violated,"
+            << "free_frames,paged_in_delta,paged_out_delta,ticks_per_s\n";
+    }
+}
+
+void MetricsExporter::onTick(unsigned long long ticks) {
+    // Sample once if the round reached a multiple of the interval
+    if (!enabled() || emu().global_tick % interval >= ticks) return;
+
+    Sample s = collect();
+    if (csv.is_open()) appendCsv(s);
+    if (!promPath.empty()) writePrometheus(s);
+}
+
+MetricsExporter::Sample MetricsExporter::collect() {
+    Sample s;
+    s.tick = emu().global_tick;
+    {
+        std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+        size_t counts[5];
+        emu().processTable.countStates(counts);
+        s.ready = static_cast<int>(counts[static_cast<size_t>(ProcessState::READY)]);
+        s.running = static_cast<int>(counts[static_cast<size_t>(ProcessState::RUNNING)]);
+        s.sleeping = static_cast<int>(counts[static_cast<size_t>(ProcessState::SLEEPING)]);
+        s.finished = static_cast<int>(counts[static_cast<size_t>(ProcessState::FINISHED)]);
+        s.violated = static_cast<int>(counts[static_cast<size_t>(ProcessState::MEMORY_VIOLATED)]);
+        s.finished += static_cast<int>(emu().finishedProcesses.finishedCount());
+        s.violated += static_cast<int>(emu().finishedProcesses.violatedCount());
+    }
+    s.utilization = emu().systemConfig.num_cpu > 0 ? static_cast<double>(s.running) / emu().systemConfig.num_cpu : 0.0;
+
+    if (emu().memoryManager) {
+        s.freeFrames = emu().memoryManager->getFreeFrameCount();
+        s.totalFrames = emu().memoryManager->getTotalFrames();
+        VMStatCounters vm = emu().memoryManager->getVMStat();
+        s.pagedIn = vm.pages_paged_in;
+        s.pagedOut = vm.pages_paged_out;
+    }
+    s.pagedInDelta = s.pagedIn - lastPagedIn;
+    s.pagedOutDelta = s.pagedOut - lastPagedOut;
+    s.instructions = emu().instructionsExecuted;
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastWall).count();
+    s.ticksPerSecond = elapsed > 0 ? (s.tick - lastTick) / elapsed : 0.0;
+
+    lastTick = s.tick;
+    lastPagedIn = s.pagedIn;
+    lastPagedOut = s.pagedOut;
+    lastWall = now;
+    return s;
+}
+
+void MetricsExporter::appendCsv(const Sample& s) {
+    csv << s.tick << ','
+        << std::fixed << std::setprecision(4) << s.utilization << ','
+        << s.ready << ',' << s.running << ',' << s.sleeping << ',' << s.finished << ',' << s.violated << ','
+        << s.freeFrames << ',' << s.pagedInDelta << ',' << s.pagedOutDelta << ','
+        << std::setprecision(1) << s.ticksPerSecond << '\n';
+    csv.flush();
+}
+
+// Writes to <path>.tmp and renames over <path> so a scraper never sees a partial file
+void MetricsExporter::writePrometheus(const Sample& s) {
+    const std::string tmpPath = promPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out.is_open()) return;
+
+        out << std::fixed << std::setprecision(4);
+        out << "# HELP csopesy_tick Current scheduler tick.\n# TYPE csopesy_tick counter\n"
+            << "csopesy_tick " << s.tick << "\n";
+        out << "# HELP csopesy_cpu_utilization_ratio Busy cores / total cores.\n# TYPE csopesy_cpu_utilization_ratio gauge\n"
+            << "csopesy_cpu_utilization_ratio " << s.utilization << "\n";
+        out << "# HELP csopesy_processes Processes by state.\n# TYPE csopesy_processes gauge\n"
+            << "csopesy_processes{state=\"ready\"} " << s.ready << "\n"
+            << "csopesy_processes{state=\"running\"} " << s.running << "\n"
+            << "csopesy_processes{state=\"sleeping\"} " << s.sleeping << "\n"
+            << "csopesy_processes{state=\"finished\"} " << s.finished << "\n"
+            << "csopesy_processes{state=\"memory_violated\"} " << s.violated << "\n";
+        out << "# HELP csopesy_frames Physical frames.\n# TYPE csopesy_frames gauge\n"
+            << "csopesy_frames{state=\"free\"} " << s.freeFrames << "\n"
+            << "csopesy_frames{state=\"used\"} " << (s.totalFrames - s.freeFrames) << "\n";
+        out << "# HELP csopesy_pages_paged_in_total Pages loaded into RAM.\n# TYPE csopesy_pages_paged_in_total counter\n"
+            << "csopesy_pages_paged_in_total " << s.pagedIn << "\n";
+        out << "# HELP csopesy_pages_paged_out_total Dirty pages written to the backing store.\n# TYPE csopesy_pages_paged_out_total counter\n"
+            << "csopesy_pages_paged_out_total " << s.pagedOut << "\n";
+        out << "# HELP csopesy_instructions_total Instructions executed.\n# TYPE csopesy_instructions_total counter\n"
+            << "csopesy_instructions_total " << s.instructions << "\n";
+        out << "# HELP csopesy_ticks_per_second Host tick rate over the last interval.\n# TYPE csopesy_ticks_per_second gauge\n"
+            << "csopesy_ticks_per_second " << s.ticksPerSecond << "\n";
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, promPath, ec);
+}
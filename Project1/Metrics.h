@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <chrono>
+
+// === Periodic metrics export ===
+// Every metrics-interval ticks, appends one row to the CSV time series and
+// atomically rewrites a Prometheus text-format file for a local scraper.
+class MetricsExporter {
+public:
+    void configure(unsigned long long interval, const std::string& csvPath, const std::string& promPath);
+    bool enabled() const { return interval > 0 && (!csvPath.empty() || !promPath.empty()); }
+
+    // Called by the scheduler at the end of every round, which covered ticks ticks
+    void onTick(unsigned long long ticks = 1);
+
+private:
+    struct Sample {
+        unsigned long long tick = 0;
+        double utilization = 0.0;
+        int ready = 0, running = 0, sleeping = 0, finished = 0, violated = 0;
+        size_t freeFrames = 0, totalFrames = 0;
+        unsigned long long pagedIn = 0, pagedOut = 0;
+        unsigned long long pagedInDelta = 0, pagedOutDelta = 0;
+        unsigned long long instructions = 0;
+        double ticksPerSecond = 0.0;
+    };
+
+    Sample collect();
+    void appendCsv(const Sample& s);
+    void writePrometheus(const Sample& s);
+
+    unsigned long long interval = 0;
+    std::string csvPath;
+    std::string promPath;
+    std::ofstream csv;
+
+    unsigned long long lastTick = 0;
+    unsigned long long lastPagedIn = 0, lastPagedOut = 0;
+    std::chrono::steady_clock::time_point lastWall;
+};
+
@@ -0,0 +1,312 @@
+#include "Optimizer.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    // Bytes of the symbol table at the bottom of page 0; READ/WRITE below this touch variables
+    constexpr int TABLE_BYTES = static_cast<int>(SymbolTable::CAPACITY * SymbolTable::VAR_SIZE);
+
+    bool inSymbolTable(int addr) {
+        return addr >= 0 && addr < TABLE_BYTES;
+    }
+
+    // MEMSET/MEMCPY ranges; an invalid range violates memory before touching anything
+    bool overlapsSymbolTable(int addr, int length) {
+        return addr >= 0 && length > 0 && addr < TABLE_BYTES;
+    }
+
+    // Variables an instruction reads and writes when it runs
+    struct Effects {
+        std::vector<SymbolId> uses;
+        std::vector<SymbolId> stores;
+        bool observesTable = false; // READ/MEMCPY from the symbol table: may see any variable
+        bool clobbersTable = false; // WRITE/MEMSET/MEMCPY into it: may overwrite any variable
+    };
+
+    bool isNoOpLoop(const ForInstruction& loop) {
+        return loop.repeatCount() <= 0 || loop.loopBody().empty();
+    }
+
+    void collectEffects(const Instruction& instr, Effects& e) {
+        auto use = [&](const Operand& op) { if (!op.isLiteral) e.uses.push_back(op.name); };
+        switch (instr.opcode()) {
+        case Opcode::DECLARE:
+            e.stores.push_back(static_cast<const DeclareInstruction&>(instr).variable());
+            break;
+        case Opcode::ADD: {
+            const auto& add = static_cast<const AddInstruction&>(instr);
+            use(add.lhs());
+            use(add.rhs());
+            e.stores.push_back(add.destination());
+            break;
+        }
+        case Opcode::SUBTRACT: {
+            const auto& sub = static_cast<const SubtractInstruction&>(instr);
+            use(sub.lhs());
+            use(sub.rhs());
+            e.stores.push_back(sub.destination());
+            break;
+        }
+        case Opcode::PRINT:
+            for (const auto& part : static_cast<const PrintInstruction&>(instr).pieces()) {
+                if (!part.isText) use(part.value);
+            }
+            break;
+        case Opcode::READ: {
+            const auto& read = static_cast<const ReadInstruction&>(instr);
+            e.stores.push_back(read.variable());
+            if (inSymbolTable(read.address())) e.observesTable = true;
+            break;
+        }
+        case Opcode::WRITE: {
+            const auto& write = static_cast<const WriteInstruction&>(instr);
+            use(write.source());
+            if (inSymbolTable(write.address())) e.clobbersTable = true;
+            break;
+        }
+        case Opcode::MEMSET: {
+            const auto& set = static_cast<const MemsetInstruction&>(instr);
+            use(set.source());
+            if (overlapsSymbolTable(set.address(), set.byteCount())) e.clobbersTable = true;
+            break;
+        }
+        case Opcode::MEMCPY: {
+            const auto& copy = static_cast<const MemcpyInstruction&>(instr);
+            if (overlapsSymbolTable(copy.source(), copy.byteCount())) e.observesTable = true;
+            if (overlapsSymbolTable(copy.destination(), copy.byteCount())) e.clobbersTable = true;
+            break;
+        }
+        case Opcode::FOR: {
+            const auto& loop = static_cast<const ForInstruction&>(instr);
+            if (isNoOpLoop(loop)) break;
+            for (const auto& body : loop.loopBody()) collectEffects(*body, e);
+            break;
+        }
+        default: // SLEEP, NOP
+            break;
+        }
+    }
+
+    Effects effectsOf(const Instruction& instr) {
+        Effects e;
+        collectEffects(instr, e);
+        return e;
+    }
+
+    // What the forward pass knows about each variable at the current instruction
+    class ConstantState {
+    public:
+        explicit ConstantState(const SymbolTable& declared) : declared(declared) {}
+
+        // True with the operand's value if it is known here; undeclared variables read as 0
+        bool known(const Operand& op, int& value) const {
+            if (op.isLiteral) {
+                value = op.literal;
+                return true;
+            }
+            auto it = values.find(op.name);
+            if (it == values.end()) {
+                if (declared.find(op.name) >= 0) return false;
+                value = 0;
+                return true;
+            }
+            if (!it->second.constant) return false;
+            value = it->second.value;
+            return true;
+        }
+
+        void setConstant(SymbolId var, int value) { values[var] = { true, value }; }
+        void setUnknown(SymbolId var) { values[var] = { false, 0 }; }
+
+        // A WRITE into the symbol table: every stored value may have changed. Variables
+        // never declared still read as 0, since lookups go through the symbol table.
+        void clobber() {
+            for (auto& [var, v] : values) v.constant = false;
+        }
+
+    private:
+        struct Value {
+            bool constant = false;
+            int value = 0;
+        };
+        const SymbolTable& declared;
+        std::unordered_map<SymbolId, Value> values; // stored so far
+    };
+
+    std::string operandText(const Operand& op, bool known, int value) {
+        return known && !op.isLiteral ? std::to_string(value) : std::string(op.token());
+    }
+
+    // Returns the instruction with known operands folded in, or nullptr if nothing changes
+    std::shared_ptr<Instruction> propagate(const Instruction& instr, ConstantState& state) {
+        switch (instr.opcode()) {
+        case Opcode::DECLARE: {
+            const auto& decl = static_cast<const DeclareInstruction&>(instr);
+            state.setConstant(decl.variable(), clampUint16(decl.value()));
+            return nullptr;
+        }
+        case Opcode::ADD:
+        case Opcode::SUBTRACT: {
+            const bool add = instr.opcode() == Opcode::ADD;
+            SymbolId target;
+            const Operand* a;
+            const Operand* b;
+            if (add) {
+                const auto& op = static_cast<const AddInstruction&>(instr);
+                target = op.destination(), a = &op.lhs(), b = &op.rhs();
+            }
+            else {
+                const auto& op = static_cast<const SubtractInstruction&>(instr);
+                target = op.destination(), a = &op.lhs(), b = &op.rhs();
+            }
+
+            int va = 0, vb = 0;
+            const bool ka = state.known(*a, va), kb = state.known(*b, vb);
+            if (ka && kb) {
+                int result = clampUint16(add ? static_cast<long long>(va) + vb : static_cast<long long>(va) - vb);
+                state.setConstant(target, result);
+                return std::make_shared<DeclareInstruction>(symbolName(target), result);
+            }
+            state.setUnknown(target);
+            if ((ka && !a->isLiteral) || (kb && !b->isLiteral)) {
+                std::string lhs = operandText(*a, ka, va), rhs = operandText(*b, kb, vb);
+                if (add) return std::make_shared<AddInstruction>(symbolName(target), lhs, rhs);
+                return std::make_shared<SubtractInstruction>(symbolName(target), lhs, rhs);
+            }
+            return nullptr;
+        }
+        case Opcode::PRINT: {
+            bool changed = false;
+            std::string expr;
+            for (const auto& part : static_cast<const PrintInstruction&>(instr).pieces()) {
+                if (!expr.empty()) expr += " + ";
+                if (part.isText) {
+                    expr += "'" + part.text + "'";
+                    continue;
+                }
+                int v = 0;
+                const bool k = state.known(part.value, v);
+                if (k && !part.value.isLiteral) changed = true;
+                expr += operandText(part.value, k, v);
+            }
+            return changed ? std::make_shared<PrintInstruction>(expr) : nullptr;
+        }
+        case Opcode::READ:
+            state.setUnknown(static_cast<const ReadInstruction&>(instr).variable());
+            return nullptr;
+        case Opcode::WRITE: {
+            const auto& write = static_cast<const WriteInstruction&>(instr);
+            if (inSymbolTable(write.address())) state.clobber();
+            int v = 0;
+            if (write.source().isLiteral || !state.known(write.source(), v)) return nullptr;
+            return std::make_shared<WriteInstruction>(write.addressText(), std::to_string(v));
+        }
+        case Opcode::MEMSET: {
+            const auto& set = static_cast<const MemsetInstruction&>(instr);
+            if (overlapsSymbolTable(set.address(), set.byteCount())) state.clobber();
+            int v = 0;
+            if (set.source().isLiteral || !state.known(set.source(), v)) return nullptr;
+            return std::make_shared<MemsetInstruction>(set.addressText(), std::to_string(v),
+                set.lengthToken());
+        }
+        case Opcode::MEMCPY: {
+            const auto& copy = static_cast<const MemcpyInstruction&>(instr);
+            if (overlapsSymbolTable(copy.destination(), copy.byteCount())) state.clobber();
+            return nullptr;
+        }
+        case Opcode::FOR: {
+            Effects e = effectsOf(instr);
+            if (e.clobbersTable) state.clobber();
+            for (SymbolId var : e.stores) state.setUnknown(var);
+            return nullptr;
+        }
+        default: // SLEEP, NOP
+            return nullptr;
+        }
+    }
+}
+
+bool parseOptimizeMode(const std::string& text, OptimizeMode& mode) {
+    if (text == "off") mode = OptimizeMode::OFF;
+    else if (text == "tick-accurate") mode = OptimizeMode::TICK_ACCURATE;
+    else if (text == "full") mode = OptimizeMode::FULL;
+    else return false;
+    return true;
+}
+
+OptimizeStats optimizeProgram(InstructionList& program, size_t from, const SymbolTable& declared,
+    OptimizeMode mode) {
+    OptimizeStats stats;
+    if (mode == OptimizeMode::OFF || from >= program.size()) return stats;
+    const size_t n = program.size() - from;
+
+    // Every variable the range may store; past 32 the symbol table overflows and which
+    // declarations get dropped would depend on the stores we remove
+    std::unordered_set<SymbolId> stored;
+    for (size_t slot = 0; slot < declared.size(); ++slot) stored.insert(declared.idAt(slot));
+    for (size_t i = 0; i < n; ++i) {
+        for (SymbolId var : effectsOf(*program[from + i]).stores) stored.insert(var);
+    }
+    if (stored.size() > SymbolTable::CAPACITY) return stats;
+
+    // Forward: fold constants, and note each variable's first store (kept for the layout)
+    std::vector<std::shared_ptr<Instruction>> out(program.begin() + from, program.end());
+    std::vector<bool> rewritten(n, false), firstStore(n, false), drop(n, false);
+    ConstantState state(declared);
+    std::unordered_set<SymbolId> declaredSoFar;
+    for (size_t slot = 0; slot < declared.size(); ++slot) declaredSoFar.insert(declared.idAt(slot));
+
+    for (size_t i = 0; i < n; ++i) {
+        const Instruction& instr = *out[i];
+        if (instr.opcode() == Opcode::FOR && isNoOpLoop(static_cast<const ForInstruction&>(instr))) {
+            drop[i] = true;
+            stats.loops++;
+            continue;
+        }
+        for (SymbolId var : effectsOf(instr).stores) {
+            if (declaredSoFar.insert(var).second) firstStore[i] = true;
+        }
+        if (auto folded = propagate(instr, state)) {
+            out[i] = std::move(folded);
+            rewritten[i] = true;
+        }
+    }
+
+    // Backward: a store is dead if nothing reads the variable before it is stored again
+    std::unordered_set<SymbolId> live;
+    for (size_t i = n; i-- > 0;) {
+        if (drop[i]) continue;
+        const Instruction& instr = *out[i];
+        const Opcode op = instr.opcode();
+        Effects e = effectsOf(instr);
+
+        const bool pureStore = op == Opcode::DECLARE || op == Opcode::ADD || op == Opcode::SUBTRACT;
+        if (pureStore && !firstStore[i] && !live.count(e.stores.front())) {
+            drop[i] = true;
+            stats.eliminated++;
+            continue;
+        }
+        if (op != Opcode::FOR) { // a loop body may read a variable before storing it
+            for (SymbolId var : e.stores) live.erase(var);
+        }
+        live.insert(e.uses.begin(), e.uses.end());
+        if (e.observesTable) live.insert(stored.begin(), stored.end());
+    }
+
+    std::vector<std::shared_ptr<Instruction>> result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (!drop[i]) {
+            if (rewritten[i]) stats.folded++;
+            result.push_back(std::move(out[i]));
+        }
+        else if (mode == OptimizeMode::TICK_ACCURATE) {
+            result.push_back(std::make_shared<NopInstruction>());
+        }
+    }
+    program.erase(program.begin() + from, program.end());
+    program.insert(program.end(), std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()));
+    return stats;
+}
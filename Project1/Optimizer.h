@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "Instruction.h"
+#include "Symbols.h"
+
+// === Program optimizer ===
+// Optional pass over a program before it runs (config "optimize", or the "optimize"
+// command for one process):
+//   - constant propagation through DECLARE/ADD/SUBTRACT, clamped to uint16 like the
+//     instructions themselves; constant operands of ADD/SUBTRACT/PRINT/WRITE become
+//     literals, and an ADD/SUBTRACT of two constants becomes a DECLARE
+//   - dead-store elimination: a DECLARE/ADD/SUBTRACT whose value no later PRINT, WRITE,
+//     arithmetic or FOR body reads is dropped
+//   - no-op FORs (zero repeats, or a body that parsed to nothing) are dropped
+// What a process prints and writes is unchanged. Memory traffic is not, which is the
+// point: what remains is the traffic the program really needs.
+//
+// The first store to each variable is always kept, so variables get the same symbol-table
+// slots as before and a READ/WRITE into the symbol-table area still sees the same layout.
+// Programs that would overflow the 32-variable symbol table are left alone.
+//
+// TICK_ACCURATE keeps timing, not paging: every instruction keeps its tick, and since a
+// page fault costs no ticks here, ticks, scheduling and finish ticks match an unoptimized
+// run. The page-0 accesses a NOP placeholder or a folded operand no longer makes are
+// still gone, so which pages are resident, LRU order and the paging counters can differ.
+enum class OptimizeMode : uint8_t {
+    OFF,
+    TICK_ACCURATE, // dropped instructions become NOPs, so every instruction keeps its tick
+    FULL,          // dropped instructions are removed
+};
+
+// "off", "tick-accurate" or "full"; false for anything else
+bool parseOptimizeMode(const std::string& text, OptimizeMode& mode);
+
+struct OptimizeStats {
+    size_t folded = 0;     // instructions rewritten with constants
+    size_t eliminated = 0; // dead stores dropped
+    size_t loops = 0;      // no-op FORs dropped
+};
+
+// Optimizes program[from..], where the variables in declared already exist with unknown
+// values (a running process's symbol table; empty for a new one). Rewritten instructions
+// are new objects, since instructions may be shared; the caller interns the result as a
+// ProgramImage, which fuses it.
+OptimizeStats optimizeProgram(InstructionList& program, size_t from, const SymbolTable& declared,
+    OptimizeMode mode);
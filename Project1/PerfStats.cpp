@@ -0,0 +1,135 @@
+#include "PerfStats.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+    struct ThreadHistograms {
+        LatencyHistogram points[static_cast<int>(PerfPoint::COUNT)];
+    };
+
+    // Every thread's histograms stay registered (and alive) so reports include exited threads
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadHistograms>> registry;
+
+    ThreadHistograms& localHistograms() {
+        thread_local std::shared_ptr<ThreadHistograms> local = []() {
+            auto h = std::make_shared<ThreadHistograms>();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.push_back(h);
+            return h;
+        }();
+        return *local;
+    }
+
+    const char* POINT_NAMES[] = {
+        "scheduler_loop_tick",
+        "execute DECLARE", "execute ADD", "execute SUBTRACT", "execute PRINT",
+        "execute SLEEP", "execute FOR", "execute READ", "execute WRITE", "execute NOP",
+        "execute MEMSET", "execute MEMCPY",
+        "access (hit)",
+        "access (fault)",
+        "fill/copy (bulk)",
+        "evictVictim",
+        "logInstructionTrace",
+    };
+
+    int floorLog2(uint64_t v) {
+        int e = 0;
+        while (v >>= 1) e++;
+        return e;
+    }
+
+    std::string formatNs(uint64_t ns) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1);
+        if (ns < 1000) out << ns << "ns";
+        else if (ns < 1000000) out << ns / 1e3 << "us";
+        else if (ns < 1000000000) out << ns / 1e6 << "ms";
+        else out << ns / 1e9 << "s";
+        return out.str();
+    }
+}
+
+int LatencyHistogram::bucketFor(uint64_t v) {
+    if (v < SUB_BUCKETS) return static_cast<int>(v);
+    int e = floorLog2(v);
+    int sub = static_cast<int>((v >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return (e - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketMidpoint(int bucket) {
+    if (bucket < SUB_BUCKETS) return static_cast<uint64_t>(bucket);
+    int e = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+    uint64_t width = 1ULL << (e - SUB_BITS);
+    uint64_t low = (1ULL << e) + sub * width;
+    return low + width / 2;
+}
+
+void recordPerf(PerfPoint point, uint64_t ns) {
+    localHistograms().points[static_cast<int>(point)].record(ns);
+}
+
+void resetPerfStats() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& h : registry) {
+        for (auto& point : h->points) {
+            for (auto& c : point.counts) c.store(0, std::memory_order_relaxed);
+            point.maxValue.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string perfReport() {
+    constexpr int POINTS = static_cast<int>(PerfPoint::COUNT);
+    std::vector<uint64_t> merged(static_cast<size_t>(POINTS) * LatencyHistogram::BUCKETS, 0);
+    uint64_t maxima[POINTS] = {};
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& h : registry) {
+            for (int p = 0; p < POINTS; ++p) {
+                const auto& hist = h->points[p];
+                for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                    merged[static_cast<size_t>(p) * LatencyHistogram::BUCKETS + b] += hist.counts[b].load(std::memory_order_relaxed);
+                }
+                maxima[p] = std::max(maxima[p], hist.maxValue.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out << std::left << std::setw(22) << "Point"
+        << std::right << std::setw(12) << "Count"
+        << std::setw(11) << "p50" << std::setw(11) << "p90"
+        << std::setw(11) << "p99" << std::setw(11) << "max" << "\n";
+
+    for (int p = 0; p < POINTS; ++p) {
+        const uint64_t* counts = &merged[static_cast<size_t>(p) * LatencyHistogram::BUCKETS];
+        uint64_t total = 0;
+        for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) total += counts[b];
+        if (total == 0) continue;
+
+        auto quantile = [&](double q) {
+            uint64_t target = static_cast<uint64_t>(q * (total - 1)) + 1;
+            uint64_t seen = 0;
+            for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                seen += counts[b];
+                if (seen >= target) return std::min(LatencyHistogram::bucketMidpoint(b), maxima[p]);
+            }
+            return maxima[p];
+        };
+
+        out << std::left << std::setw(22) << POINT_NAMES[p]
+            << std::right << std::setw(12) << total
+            << std::setw(11) << formatNs(quantile(0.50))
+            << std::setw(11) << formatNs(quantile(0.90))
+            << std::setw(11) << formatNs(quantile(0.99))
+            << std::setw(11) << formatNs(maxima[p]) << "\n";
+    }
+    return out.str();
+}
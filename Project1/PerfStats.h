@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "Instruction.h"
+
+// === Host-time latency histograms ===
+// Log-linear buckets (16 sub-buckets per power of two, ~6% resolution) kept per
+// thread and merged when read by perf-report. Build with CSOPESY_NO_PERF to
+// compile every PERF_SCOPE out.
+enum class PerfPoint {
+    SCHEDULER_TICK,
+    EXEC_DECLARE, EXEC_ADD, EXEC_SUBTRACT, EXEC_PRINT, EXEC_SLEEP, EXEC_FOR, EXEC_READ, EXEC_WRITE, EXEC_NOP,
+    EXEC_MEMSET, EXEC_MEMCPY,
+    ACCESS_HIT,
+    ACCESS_FAULT,
+    ACCESS_BULK,
+    EVICT_VICTIM,
+    TRACE_WRITE,
+    COUNT
+};
+
+inline PerfPoint perfPointFor(Opcode op) {
+    return static_cast<PerfPoint>(static_cast<int>(PerfPoint::EXEC_DECLARE) + static_cast<int>(op));
+}
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    // Single writer (the owning thread); relaxed atomics let readers merge concurrently
+    void record(uint64_t ns) {
+        auto& c = counts[bucketFor(ns)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ns > maxValue.load(std::memory_order_relaxed)) maxValue.store(ns, std::memory_order_relaxed);
+    }
+
+    static int bucketFor(uint64_t v);
+    static uint64_t bucketMidpoint(int bucket);
+
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> maxValue{ 0 };
+};
+
+void recordPerf(PerfPoint point, uint64_t ns);
+void resetPerfStats();
+std::string perfReport();
+
+class PerfScope {
+public:
+    explicit PerfScope(PerfPoint point) : point(point), start(std::chrono::steady_clock::now()) {}
+    ~PerfScope() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        recordPerf(point, static_cast<uint64_t>(ns));
+    }
+    void relabel(PerfPoint p) { point = p; } // e.g. an access that turned out to fault
+
+private:
+    PerfPoint point;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef CSOPESY_NO_PERF
+#define PERF_SCOPE(var, point) do {} while (0)
+#define PERF_RELABEL(var, point) do {} while (0)
+#else
+#define PERF_SCOPE(var, point) PerfScope var(point)
+#define PERF_RELABEL(var, point) var.relabel(point)
+#endif
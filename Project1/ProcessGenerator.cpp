@@ -0,0 +1,115 @@
+#include "ProcessGenerator.h"
+#include "Emulator.h"
+#include "Instruction.h"
+
+// Stream family for auto-created workloads (screen -s processes use the pid family)
+static constexpr uint64_t AUTO_PROCESS_STREAM = 1;
+
+ProcessGenerator::ProcessGenerator(Emulator& owner, size_t capacity) : owner(owner), capacity(capacity) {}
+
+ProcessGenerator::~ProcessGenerator() {
+    stop();
+}
+
+void ProcessGenerator::start() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (running) return;
+    if (worker.joinable()) worker.join();
+    running = true;
+    worker = std::thread(&ProcessGenerator::run, this);
+}
+
+void ProcessGenerator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+    notFull.notify_all();
+    notEmpty.notify_all();
+    if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) worker.join();
+}
+
+void ProcessGenerator::reset() {
+    stop();
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.clear();
+    nextIndex = 0;
+    nextPopIndex = 0;
+    underrunCount.store(0);
+}
+
+bool ProcessGenerator::pop(Process& out, bool wait) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (queue.empty()) {
+        if (!wait) {
+            underrunCount++;
+            return false;
+        }
+        notEmpty.wait(lock, [this]() { return !queue.empty() || !running; });
+        if (queue.empty()) return false;
+    }
+    out = std::move(queue.front());
+    queue.pop_front();
+    nextPopIndex++;
+    lock.unlock();
+    notFull.notify_one();
+    return true;
+}
+
+size_t ProcessGenerator::queued() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.size();
+}
+
+unsigned long long ProcessGenerator::nextToAdmit() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return nextPopIndex;
+}
+
+void ProcessGenerator::resumeAt(unsigned long long index) {
+    reset();
+    std::lock_guard<std::mutex> lock(queueMutex);
+    nextIndex = index;
+    nextPopIndex = index;
+}
+
+// Builds the index-th auto-created process; depends only on the seed and index
+Process ProcessGenerator::build(unsigned long long index) const {
+    Process newProc(owner.processTable.resource());
+    newProc.setState(ProcessState::READY);
+
+    Rng rng = Rng::forStream(owner.systemConfig.seed, AUTO_PROCESS_STREAM, index);
+    int insCount = static_cast<int>(rng.range(owner.systemConfig.min_ins, owner.systemConfig.max_ins));
+
+    // Memory Allocation
+    size_t memSize = static_cast<size_t>(rng.range(owner.systemConfig.min_mem_per_proc, owner.systemConfig.max_mem_per_proc));
+    newProc.memory_required = memSize;
+    InstructionList ins;
+    generateDummyInstructions(ins, insCount, (int)memSize, rng);
+    newProc.program = prepareProgram(std::move(ins));
+    int pages = (memSize + owner.systemConfig.mem_per_frame - 1) / owner.systemConfig.mem_per_frame;
+    owner.memoryManager->initializePageTable(newProc, pages);
+    return newProc;
+}
+
+void ProcessGenerator::run() {
+    EmulatorBinding bind(owner);
+    while (true) {
+        unsigned long long index;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            notFull.wait(lock, [this]() { return queue.size() < capacity || !running; });
+            if (!running) return;
+            index = nextIndex++;
+        }
+
+        // Build outside the lock so the tick loop can keep popping
+        Process built = build(index);
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(std::move(built));
+        }
+        notEmpty.notify_one();
+    }
+}
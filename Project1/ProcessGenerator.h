@@ -0,0 +1,53 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include "globals.h"
+
+class Emulator;
+
+// === Background process generator ===
+// A producer thread pre-builds auto-created processes (instructions + page table)
+// into a bounded queue so the scheduler tick only has to pop and admit them.
+// Processes come out without a pid or name; those are assigned on admission.
+class ProcessGenerator {
+public:
+    explicit ProcessGenerator(Emulator& owner, size_t capacity = 32);
+    ~ProcessGenerator();
+
+    void start();
+    void stop();   // stops producing; already-built processes stay queued
+    void reset();  // stop, drop the queue and restart the generation sequence
+
+    // Pops the next pre-built process. With wait=true blocks until one is ready
+    // (returns false only if the generator is stopped and empty).
+    bool pop(Process& out, bool wait);
+
+    size_t queued();
+
+    // Index of the next process pop() will hand out
+    unsigned long long nextToAdmit();
+    // Stops, drops the queue and continues the sequence at index (used by restore)
+    void resumeAt(unsigned long long index);
+    unsigned long long underruns() const { return underrunCount.load(); }
+
+private:
+    Process build(unsigned long long index) const;
+    void run();
+
+    Emulator& owner;
+    size_t capacity;
+    std::deque<Process> queue;
+    std::mutex queueMutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::thread worker;
+    bool running = false;
+    unsigned long long nextIndex = 0;     // next index to build
+    unsigned long long nextPopIndex = 0;  // index of the next process pop() hands out
+    std::atomic<unsigned long long> underrunCount{ 0 };
+};
+
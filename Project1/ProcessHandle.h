@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// === Process handle ===
+// Names a process-table slot and the generation it was issued for. Once the process
+// is retired the slot's generation moves on, so the handle stops resolving instead
+// of pointing at whatever process reuses the slot.
+struct ProcessHandle {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t index = NONE;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != NONE; }
+    explicit operator bool() const { return valid(); }
+    bool operator==(const ProcessHandle& other) const = default;
+};
@@ -0,0 +1,125 @@
+#include "globals.h"
+
+#include <algorithm>
+
+ProcessHandle ProcessTable::insert(Process p) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        // Reuse a retired slot; the record is still bound to it, so assigning moves the
+        // hot fields straight into the arrays
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        records[slot] = std::move(p);
+    }
+    else {
+        slot = static_cast<uint32_t>(records.size());
+        states.push_back(p.state());
+        sleepCounters.push_back(p.sleepCounter());
+        // Slots emptied by clear() keep their generation, so handles from before it stay stale
+        if (slot == generations.size()) generations.push_back(0);
+        live.push_back(0);
+        // Records always allocate from the pool; p's storage moves in if it came from there too
+        records.emplace_back(&pool);
+        records.back() = std::move(p);
+        records.back().hot.table = this;
+        records.back().hot.slot = slot;
+    }
+
+    live[slot] = 1;
+    liveCount++;
+    if (records[slot].pid >= 0) pidIndex[records[slot].pid] = slot;
+    return ProcessHandle{ slot, generations[slot] };
+}
+
+bool ProcessTable::erase(ProcessHandle h) {
+    if (!get(h)) return false;
+    Process& record = records[h.index];
+    pidIndex.erase(record.pid);
+    record = Process(&pool); // hands the page table and logs back to the pool and drops the program image
+
+    states[h.index] = ProcessState::FINISHED;
+    sleepCounters[h.index] = 0;
+    live[h.index] = 0;
+    generations[h.index]++;
+    freeSlots.push_back(h.index);
+    liveCount--;
+    return true;
+}
+
+void ProcessTable::clear() {
+    records.clear();
+    states.clear();
+    sleepCounters.clear();
+    for (uint32_t& generation : generations) generation++;
+    live.clear();
+    freeSlots.clear();
+    pidIndex.clear();
+    liveCount = 0;
+}
+
+Process* ProcessTable::get(ProcessHandle h) {
+    if (h.index >= records.size() || !live[h.index] || generations[h.index] != h.generation) return nullptr;
+    return &records[h.index];
+}
+
+const Process* ProcessTable::get(ProcessHandle h) const {
+    if (h.index >= records.size() || !live[h.index] || generations[h.index] != h.generation) return nullptr;
+    return &records[h.index];
+}
+
+ProcessHandle ProcessTable::handleAt(size_t slot) const {
+    if (slot >= records.size() || !live[slot]) return ProcessHandle{};
+    return ProcessHandle{ static_cast<uint32_t>(slot), generations[slot] };
+}
+
+ProcessHandle ProcessTable::find(int pid) const {
+    auto it = pidIndex.find(pid);
+    if (it == pidIndex.end()) return ProcessHandle{};
+    return ProcessHandle{ it->second, generations[it->second] };
+}
+
+bool ProcessTable::anyActive() const {
+    for (ProcessState s : states) {
+        if (s == ProcessState::READY || s == ProcessState::RUNNING || s == ProcessState::SLEEPING) return true;
+    }
+    return false;
+}
+
+bool ProcessTable::anyReadyExcept(size_t slot) const {
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i] == ProcessState::READY && i != slot) return true;
+    }
+    return false;
+}
+
+size_t ProcessTable::nextReady(size_t from, bool wrap) const {
+    const size_t n = states.size();
+    if (from >= n) from = wrap && n > 0 ? from % n : n;
+    for (size_t i = from; i < n; ++i) {
+        if (states[i] == ProcessState::READY) return i;
+    }
+    if (wrap) {
+        for (size_t i = 0; i < from; ++i) {
+            if (states[i] == ProcessState::READY) return i;
+        }
+    }
+    return n;
+}
+
+void ProcessTable::countStates(size_t counts[5]) const {
+    for (size_t i = 0; i < 5; ++i) counts[i] = 0;
+    for (ProcessState s : states) counts[static_cast<size_t>(s)]++;
+    counts[static_cast<size_t>(ProcessState::FINISHED)] -= records.size() - liveCount; // retired slots
+}
+
+void ProcessTable::wakeSleepers(int ticks) {
+    // Branch-light so the loop vectorizes: only SLEEPING slots with a count left tick down
+    const size_t n = states.size();
+    ProcessState* s = states.data();
+    int* sleep = sleepCounters.data();
+    for (size_t i = 0; i < n; ++i) {
+        bool counting = s[i] == ProcessState::SLEEPING && sleep[i] > 0;
+        sleep[i] -= counting ? std::min(sleep[i], ticks) : 0;
+        if (counting && sleep[i] == 0) s[i] = ProcessState::READY;
+    }
+}
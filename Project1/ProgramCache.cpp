@@ -0,0 +1,249 @@
+#include "ProgramCache.h"
+#include "Instruction.h"
+#include "ProgramLoader.h"
+#include "Snapshot.h"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+uint64_t programSourceHash(std::string_view source) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a over the version, then the text
+    auto mix = [&](unsigned char c) {
+        h ^= c;
+        h *= 1099511628211ull;
+    };
+    for (int shift = 0; shift < 32; shift += 8) mix(static_cast<unsigned char>(PROGRAM_CACHE_VERSION >> shift));
+    for (char c : source) mix(static_cast<unsigned char>(c));
+    return h;
+}
+
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x47505343; // "CSPG"
+    constexpr int MAX_DEPTH = 2;                 // a FOR body holds no further FOR bodies
+
+    std::filesystem::path entryPath(const std::string& dir, std::string_view source) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.prog", static_cast<unsigned long long>(programSourceHash(source)));
+        return std::filesystem::path(dir) / name;
+    }
+
+    // Temp name for one store: the pid separates processes sharing the cache, the counter
+    // separates this process's threads, and the random part covers a reused pid finding a
+    // temp file left behind by a writer that died
+    std::filesystem::path tempPath(const std::filesystem::path& entry) {
+        static std::atomic<unsigned> counter{ 0 };
+#ifdef _WIN32
+        const unsigned long pid = static_cast<unsigned long>(_getpid());
+#else
+        const unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+        char suffix[64];
+        std::snprintf(suffix, sizeof(suffix), ".%lu.%u.%08x.tmp", pid, counter.fetch_add(1),
+            static_cast<unsigned>(std::random_device{}()));
+        std::filesystem::path tmp = entry;
+        tmp += suffix;
+        return tmp;
+    }
+
+    // === Encoding ===
+    // One opcode byte, then the operands as their source tokens or integers, so decoding
+    // calls the instruction's constructor directly and never goes through parseInstruction
+    void encode(SnapshotWriter& out, const Instruction& instr) {
+        out.u8(static_cast<uint8_t>(instr.opcode()));
+        switch (instr.opcode()) {
+        case Opcode::DECLARE: {
+            const auto& decl = static_cast<const DeclareInstruction&>(instr);
+            out.str(symbolName(decl.variable()));
+            out.i32(decl.value());
+            break;
+        }
+        case Opcode::ADD: {
+            const auto& add = static_cast<const AddInstruction&>(instr);
+            out.str(symbolName(add.destination()));
+            out.str(add.lhs().token());
+            out.str(add.rhs().token());
+            break;
+        }
+        case Opcode::SUBTRACT: {
+            const auto& sub = static_cast<const SubtractInstruction&>(instr);
+            out.str(symbolName(sub.destination()));
+            out.str(sub.lhs().token());
+            out.str(sub.rhs().token());
+            break;
+        }
+        case Opcode::PRINT:
+            out.str(static_cast<const PrintInstruction&>(instr).text());
+            break;
+        case Opcode::SLEEP:
+            out.i32(static_cast<const SleepInstruction&>(instr).ticks());
+            break;
+        case Opcode::FOR: {
+            const auto& loop = static_cast<const ForInstruction&>(instr);
+            out.str(loop.bodyText());
+            out.i32(loop.repeatCount());
+            out.u32(static_cast<uint32_t>(loop.loopBody().size()));
+            for (const auto& body : loop.loopBody()) encode(out, *body);
+            break;
+        }
+        case Opcode::READ: {
+            const auto& read = static_cast<const ReadInstruction&>(instr);
+            out.str(read.addressText());
+            out.str(symbolName(read.variable()));
+            break;
+        }
+        case Opcode::WRITE: {
+            const auto& write = static_cast<const WriteInstruction&>(instr);
+            out.str(write.addressText());
+            out.str(write.source().token());
+            break;
+        }
+        case Opcode::MEMSET: {
+            const auto& set = static_cast<const MemsetInstruction&>(instr);
+            out.str(set.addressText());
+            out.str(set.source().token());
+            out.str(set.lengthToken());
+            break;
+        }
+        case Opcode::MEMCPY: {
+            const auto& copy = static_cast<const MemcpyInstruction&>(instr);
+            out.str(copy.destinationText());
+            out.str(copy.sourceText());
+            out.str(copy.lengthToken());
+            break;
+        }
+        default: // NOP
+            break;
+        }
+    }
+
+    std::shared_ptr<Instruction> decode(SnapshotReader& in, int depth) {
+        const uint8_t op = in.u8();
+        if (!in.good()) return nullptr;
+        switch (static_cast<Opcode>(op)) {
+        case Opcode::DECLARE: {
+            std::string var = in.str();
+            int value = in.i32();
+            return std::make_shared<DeclareInstruction>(var, value);
+        }
+        case Opcode::ADD:
+        case Opcode::SUBTRACT: {
+            std::string target = in.str();
+            std::string lhs = in.str();
+            std::string rhs = in.str();
+            if (static_cast<Opcode>(op) == Opcode::ADD) return std::make_shared<AddInstruction>(target, lhs, rhs);
+            return std::make_shared<SubtractInstruction>(target, lhs, rhs);
+        }
+        case Opcode::PRINT:
+            return std::make_shared<PrintInstruction>(in.str());
+        case Opcode::SLEEP:
+            return std::make_shared<SleepInstruction>(in.i32());
+        case Opcode::FOR: {
+            if (depth >= MAX_DEPTH) return nullptr;
+            std::string body = in.str();
+            int repeats = in.i32();
+            uint32_t count = in.u32();
+            if (!in.fits(count, 1)) return nullptr;
+            std::vector<std::shared_ptr<Instruction>> parsed;
+            parsed.reserve(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                auto instr = decode(in, depth + 1);
+                if (!instr) return nullptr;
+                parsed.push_back(std::move(instr));
+            }
+            return std::make_shared<ForInstruction>(body, repeats, std::move(parsed));
+        }
+        case Opcode::READ: {
+            std::string addr = in.str();
+            std::string var = in.str();
+            return std::make_shared<ReadInstruction>(addr, var);
+        }
+        case Opcode::WRITE: {
+            std::string addr = in.str();
+            std::string value = in.str();
+            return std::make_shared<WriteInstruction>(addr, value);
+        }
+        case Opcode::MEMSET:
+        case Opcode::MEMCPY: {
+            std::string first = in.str();
+            std::string second = in.str();
+            std::string length = in.str();
+            if (static_cast<Opcode>(op) == Opcode::MEMSET) return std::make_shared<MemsetInstruction>(first, second, length);
+            return std::make_shared<MemcpyInstruction>(first, second, length);
+        }
+        case Opcode::NOP:
+            return std::make_shared<NopInstruction>();
+        default:
+            return nullptr;
+        }
+    }
+}
+
+bool loadCachedProgram(const std::string& dir, std::string_view source,
+    std::vector<std::shared_ptr<Instruction>>& out) {
+    MappedFile file;
+    std::string error;
+    std::error_code ec;
+    const std::filesystem::path path = entryPath(dir, source);
+    if (!std::filesystem::exists(path, ec) || !file.open(path.string(), error)) return false;
+
+    // Header: magic, version, source length; then the source itself, then the program
+    std::string_view data = file.view();
+    SnapshotReader header(data.data(), data.size());
+    constexpr size_t HEADER_BYTES = 16;
+    if (header.u32() != CACHE_MAGIC || header.u32() != PROGRAM_CACHE_VERSION) return false;
+    if (header.u64() != source.size() || !header.fits(source.size(), 1)) return false;
+    if (data.substr(HEADER_BYTES, source.size()) != source) return false;
+    SnapshotReader body(data.data() + HEADER_BYTES + source.size(), data.size() - HEADER_BYTES - source.size());
+
+    const uint32_t count = body.u32();
+    if (!body.fits(count, 1)) return false;
+    std::vector<std::shared_ptr<Instruction>> program;
+    program.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        auto instr = decode(body, 0);
+        if (!instr) return false;
+        program.push_back(std::move(instr));
+    }
+    if (!body.good() || !body.atEnd()) return false;
+    out = std::move(program);
+    return true;
+}
+
+void storeCachedProgram(const std::string& dir, std::string_view source,
+    const std::vector<std::shared_ptr<Instruction>>& program) {
+    SnapshotWriter out;
+    out.u32(CACHE_MAGIC);
+    out.u32(PROGRAM_CACHE_VERSION);
+    out.u64(source.size());
+    out.raw(source.data(), source.size());
+    out.u32(static_cast<uint32_t>(program.size()));
+    for (const auto& instr : program) encode(out, *instr);
+
+    // Written beside the entry and renamed over it, so a concurrent load never maps a
+    // partial file
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    const std::filesystem::path path = entryPath(dir, source);
+    const std::filesystem::path tmpPath = tempPath(path);
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file.write(out.bytes().data(), static_cast<std::streamsize>(out.bytes().size()));
+        if (!file) {
+            file.close();
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) std::filesystem::remove(tmpPath, ec);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Instruction;
+
+// === Compiled program cache ===
+// With "program-cache <dir>" in the config, program files are compiled once: the parsed
+// program is stored in <dir> under a hash of the source text and PROGRAM_CACHE_VERSION,
+// and later loads of the same text map that file and build the instructions straight from
+// it instead of running the parser. Each entry also holds the source, so a hash collision
+// is a miss, not a wrong program.
+//
+// Bump the version whenever the parser or an instruction's encoding changes; entries
+// written by other versions are then never looked up.
+constexpr uint32_t PROGRAM_CACHE_VERSION = 2;
+
+// 64-bit FNV-1a of the source and PROGRAM_CACHE_VERSION; names cache entries, and keys
+// the shared parses in loadProgramsParallel
+uint64_t programSourceHash(std::string_view source);
+
+// True with the cached program for this source; false on a miss or an unreadable entry
+bool loadCachedProgram(const std::string& dir, std::string_view source,
+    std::vector<std::shared_ptr<Instruction>>& out);
+
+// Best effort: a cache that cannot be written only costs the next load a parse
+void storeCachedProgram(const std::string& dir, std::string_view source,
+    const std::vector<std::shared_ptr<Instruction>>& program);
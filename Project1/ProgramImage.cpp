@@ -0,0 +1,116 @@
+#include "ProgramImage.h"
+
+#include <algorithm>
+#include <string>
+
+namespace {
+    // Interned images by content hash; weak, so an image dies with its last process
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_multimap<uint64_t, std::weak_ptr<const ProgramImage>> images;
+        size_t sweepAt = 1024; // drop expired entries once the map grows past this
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    // Formats without allocating unless the instruction is longer than the buffer
+    template <typename Fn>
+    void withText(const Instruction& instr, Fn&& fn) {
+        char text[256];
+        TextBuffer out(text, sizeof(text));
+        instr.format(out);
+        if (!out.overflowed()) fn(out.view());
+        else fn(std::string_view(instr.toString()));
+    }
+
+    uint64_t contentHash(const InstructionList& code) {
+        uint64_t h = 1469598103934665603ull; // FNV-1a
+        auto mix = [&](unsigned char c) {
+            h ^= c;
+            h *= 1099511628211ull;
+        };
+        for (const auto& instr : code) {
+            withText(*instr, [&](std::string_view text) {
+                for (char c : text) mix(static_cast<unsigned char>(c));
+            });
+            mix('\n');
+        }
+        return h;
+    }
+
+    bool sameText(const Instruction& a, const Instruction& b) {
+        if (&a == &b) return true;
+        if (a.opcode() != b.opcode()) return false;
+        bool same = false;
+        withText(a, [&](std::string_view ta) {
+            withText(b, [&](std::string_view tb) { same = ta == tb; });
+        });
+        return same;
+    }
+
+    bool sameContent(const ProgramImage& image, const InstructionList& code) {
+        if (image.size() != code.size()) return false;
+        for (size_t i = 0; i < code.size(); ++i) {
+            if (!sameText(*image[i], *code[i])) return false;
+        }
+        return true;
+    }
+}
+
+ProgramRef ProgramImage::intern(InstructionList code) {
+    const uint64_t hash = contentHash(code);
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto [first, last] = reg.images.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (ProgramRef existing = it->second.lock()) {
+            if (sameContent(*existing, code)) return existing;
+        }
+    }
+
+    auto image = std::make_shared<const ProgramImage>(std::move(code));
+    if (reg.images.size() >= reg.sweepAt) {
+        std::erase_if(reg.images, [](const auto& entry) { return entry.second.expired(); });
+        reg.sweepAt = std::max<size_t>(1024, reg.images.size() * 2);
+    }
+    reg.images.emplace(hash, image);
+    return image;
+}
+
+ProgramRef ProgramImage::none() {
+    static const ProgramRef image = std::make_shared<const ProgramImage>(InstructionList{});
+    return image;
+}
+
+size_t ProgramImage::internedCount() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t live = 0;
+    for (const auto& [hash, image] : reg.images) {
+        if (!image.expired()) live++;
+    }
+    return live;
+}
+
+ProgramRef ProgramImage::expandLoop(size_t pc) const {
+    std::lock_guard<std::mutex> lock(expansionsMutex);
+    auto it = expansions.find(pc);
+    if (it != expansions.end()) return it->second;
+
+    const auto& loop = static_cast<const ForInstruction&>(*code[pc]);
+    const auto& body = loop.loopBody();
+    const size_t repeats = static_cast<size_t>(std::max(loop.repeatCount(), 0));
+    InstructionList expanded;
+    expanded.reserve(code.size() - 1 + body.size() * repeats);
+    expanded.insert(expanded.end(), code.begin(), code.begin() + pc);
+    for (size_t r = 0; r < repeats; ++r) expanded.insert(expanded.end(), body.begin(), body.end());
+    expanded.insert(expanded.end(), code.begin() + pc + 1, code.end());
+
+    ProgramRef image = std::make_shared<const ProgramImage>(std::move(expanded));
+    expansions.emplace(pc, image);
+    return image;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Instruction.h"
+
+class ProgramImage;
+
+// A process's program: immutable and shared by every process running the same code
+using ProgramRef = std::shared_ptr<const ProgramImage>;
+
+// === Program images ===
+// Images are hash-consed by content (the instructions' source text), so processes created
+// from the same string or file share one image however many there are. Nothing edits an
+// image in place. A FOR moves its process to the image with the loop expanded, and that
+// image is cached on the one it came from, so identical processes share each expanded
+// state too. A process that really diverges (e.g. the optimize command) gets a new image
+// of its own.
+class ProgramImage {
+public:
+    size_t size() const { return code.size(); }
+    bool empty() const { return code.empty(); }
+    const std::shared_ptr<Instruction>& operator[](size_t i) const { return code[i]; }
+    // Instructions in the superinstruction starting at i (see fuseSuperinstructions); 1 = none
+    int fusedLength(size_t i) const { return fused[i]; }
+    auto begin() const { return code.begin(); }
+    auto end() const { return code.end(); }
+
+    // This image with the FOR at pc replaced by its body, repeated; built once per pc
+    ProgramRef expandLoop(size_t pc) const;
+
+    // The shared image with this content
+    static ProgramRef intern(InstructionList code);
+    static ProgramRef none(); // the empty program
+
+    // Live interned images, all processes together (shown by vmstat)
+    static size_t internedCount();
+
+    // Marks superinstructions before the image can be shared
+    explicit ProgramImage(InstructionList code) : code(std::move(code)), fused(fuseSuperinstructions(this->code)) {}
+
+private:
+    InstructionList code;
+    std::vector<uint8_t> fused; // per position, parallel to code
+
+    mutable std::mutex expansionsMutex;
+    mutable std::unordered_map<size_t, ProgramRef> expansions; // by FOR position
+};
@@ -0,0 +1,228 @@
+#include "ProgramLoader.h"
+#include "Instruction.h"
+#include "ProgramCache.h"
+#include "ThreadPool.h"
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    fileHandle = file;
+    length = static_cast<size_t>(size.QuadPart);
+    if (length == 0) return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        error = "cannot map " + path;
+        close();
+        return false;
+    }
+    mappingHandle = mapping;
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        error = "cannot map " + path;
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        error = "cannot stat " + path;
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            error = "cannot map " + path;
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd); // the mapping stays valid after the descriptor is closed
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data) munmap(const_cast<char*>(data), length);
+#endif
+    data = nullptr;
+    length = 0;
+}
+
+bool parseProgramText(std::string_view text, std::vector<std::shared_ptr<Instruction>>& out, std::string& error) {
+    int line = 1;
+    int depth = 0;        // inside FOR([...])
+    bool inQuote = false; // inside '...'
+    bool atLineStart = true;
+    bool comment = false;
+    size_t start = 0;
+
+    auto flush = [&](size_t end) {
+        std::string_view piece = text.substr(start, end - start);
+        start = end + 1;
+        size_t first = piece.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos) return true;
+        size_t last = piece.find_last_not_of(" \t\r\n");
+        std::string stmt(piece.substr(first, last - first + 1));
+
+        auto inst = parseInstruction(stmt);
+        if (!inst) {
+            error = "line " + std::to_string(line) + ": invalid instruction: " + stmt;
+            return false;
+        }
+        out.push_back(std::move(inst));
+        return true;
+    };
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (comment) {
+            if (c == '\n') {
+                comment = false;
+                atLineStart = true;
+                start = i + 1;
+                line++;
+            }
+            continue;
+        }
+        if (atLineStart && c == '#') {
+            comment = true;
+            continue;
+        }
+        if (c != ' ' && c != '\t') atLineStart = false;
+
+        if (c == '\'') inQuote = !inQuote;
+        else if (!inQuote && c == '[') depth++;
+        else if (!inQuote && c == ']' && depth > 0) depth--;
+        else if (c == '\n' || (c == ';' && !inQuote && depth == 0)) {
+            if (c == '\n' && (inQuote || depth > 0)) {
+                error = "line " + std::to_string(line) + ": unterminated quote or FOR body";
+                return false;
+            }
+            if (!flush(i)) return false;
+            if (c == '\n') {
+                line++;
+                atLineStart = true;
+            }
+        }
+    }
+    if (!comment && start < text.size() && !flush(text.size())) return false;
+    return true;
+}
+
+std::vector<LoadedProgram> loadProgramsParallel(const std::vector<std::string>& paths, ThreadPool& pool,
+    const std::string& cacheDir) {
+    std::vector<LoadedProgram> programs(paths.size());
+    std::vector<std::future<void>> pending;
+    pending.reserve(paths.size());
+
+    // Files with the same text share one parse, so a directory of copies of one job
+    // holds one set of instructions (and the processes one program image). Keyed by a
+    // hash of the text, never the text itself: a hit is checked against the file that
+    // made the entry, so a collision only costs a parse of its own.
+    struct Parsed {
+        std::string path; // the first file parsed with this hash
+        std::vector<std::shared_ptr<Instruction>> instructions;
+    };
+    std::mutex parsedMutex;
+    std::unordered_map<uint64_t, Parsed> parsedByHash;
+
+    // The instructions already parsed from text, if any
+    auto findParsed = [&parsedMutex, &parsedByHash](uint64_t hash, std::string_view text,
+        std::vector<std::shared_ptr<Instruction>>& out) {
+        Parsed entry;
+        {
+            std::lock_guard<std::mutex> lock(parsedMutex);
+            auto it = parsedByHash.find(hash);
+            if (it == parsedByHash.end()) return false;
+            entry = it->second;
+        }
+        MappedFile first;
+        std::string error;
+        if (!first.open(entry.path, error) || first.view() != text) return false;
+        out = std::move(entry.instructions);
+        return true;
+    };
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        pending.push_back(pool.submit([&programs, &paths, &cacheDir, &parsedMutex, &parsedByHash, &findParsed, i]() {
+            LoadedProgram& prog = programs[i];
+            prog.path = paths[i];
+            prog.name = std::filesystem::path(paths[i]).stem().string();
+
+            MappedFile file;
+            if (!file.open(paths[i], prog.error)) return;
+            const std::string_view text = file.view();
+            const uint64_t hash = programSourceHash(text);
+            if (findParsed(hash, text, prog.instructions)) return;
+
+            if (!cacheDir.empty() && loadCachedProgram(cacheDir, text, prog.instructions)) {
+                prog.cached = true;
+            }
+            else if (!parseProgramText(text, prog.instructions, prog.error)) {
+                prog.instructions.clear();
+                return;
+            }
+            else if (prog.instructions.empty()) {
+                prog.error = "no instructions";
+                return;
+            }
+            else if (!cacheDir.empty()) {
+                storeCachedProgram(cacheDir, text, prog.instructions);
+            }
+
+            // Parsed or read from the cache, later copies share it
+            bool inserted = false;
+            {
+                std::lock_guard<std::mutex> lock(parsedMutex);
+                inserted = parsedByHash.emplace(hash, Parsed{ paths[i], prog.instructions }).second;
+            }
+            // Another worker may have loaded the same text meanwhile; keep the first
+            if (!inserted) findParsed(hash, text, prog.instructions);
+        }));
+    }
+    for (auto& f : pending) f.get();
+    return programs;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+class Instruction;
+class ThreadPool;
+
+// === Read-only memory-mapped file ===
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+    std::string_view view() const { return { data, length }; }
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+// === Program files ===
+// One instruction per line and/or separated by ';' (outside FOR brackets and quotes).
+// Lines starting with '#' are comments.
+bool parseProgramText(std::string_view text, std::vector<std::shared_ptr<Instruction>>& out, std::string& error);
+
+struct LoadedProgram {
+    std::string name;   // file stem
+    std::string path;
+    std::vector<std::shared_ptr<Instruction>> instructions;
+    std::string error;  // empty on success
+    bool cached = false; // built from the compiled program cache instead of parsed
+};
+
+// Maps and parses every file in parallel on the pool; results keep the input order.
+// With a cacheDir, programs are looked up in and added to the compiled program cache
+// (see ProgramCache.h).
+std::vector<LoadedProgram> loadProgramsParallel(const std::vector<std::string>& paths, ThreadPool& pool,
+    const std::string& cacheDir = {});
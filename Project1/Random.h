@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+// === Workload RNG ===
+// xoshiro256** seeded through splitmix64. Each process gets its own stream derived
+// from (seed, pid), so workloads are reproducible and can be generated on any thread.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0) {
+        uint64_t x = seed;
+        for (auto& word : s) word = splitmix64(x);
+    }
+
+    // Independent stream for one process: same seed + pid always yields the same sequence
+    static Rng forProcess(uint64_t seed, uint64_t pid) {
+        return forStream(seed, 0, pid);
+    }
+
+    // Independent stream for the index-th item of a stream family (e.g. auto-created processes)
+    static Rng forStream(uint64_t seed, uint64_t family, uint64_t index) {
+        uint64_t mixed = seed ^ (index * 0x9E3779B97F4A7C15ULL) ^ (family * 0xD1B54A32D192ED03ULL);
+        return Rng(splitmix64(mixed));
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform value in [0, bound); bound must be > 0
+    uint64_t below(uint64_t bound) {
+        // Modulo bias is negligible for the small bounds used by workload generation
+        return next() % bound;
+    }
+
+    // Uniform value in [lo, hi]
+    int64_t range(int64_t lo, int64_t hi) {
+        if (hi <= lo) return lo;
+        return lo + static_cast<int64_t>(below(static_cast<uint64_t>(hi - lo) + 1));
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static uint64_t splitmix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
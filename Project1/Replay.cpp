@@ -0,0 +1,265 @@
+#include "Replay.h"
+#include "Emulator.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <charconv>
+#include <type_traits>
+
+namespace {
+    std::string hex(uint64_t v) {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << v;
+        return out.str();
+    }
+
+    // A whole token of hex digits; false for anything else (a truncated or edited recording)
+    bool parseHex(const std::string& text, uint64_t& value) {
+        const char* end = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(text.data(), end, value, 16);
+        return !text.empty() && ec == std::errc() && ptr == end;
+    }
+
+    struct RecordedCommand {
+        unsigned long long tick = 0;
+        int session = 0;
+        uint64_t digest = 0;
+        std::string line;
+    };
+}
+
+uint64_t stateDigest(Emulator& instance) {
+    StateHasher h;
+    h.add(instance.global_tick);
+    h.add(static_cast<uint64_t>(instance.nextPID));
+    h.add(static_cast<uint64_t>(instance.rrCursor));
+    h.add(instance.instructionsExecuted);
+
+    std::lock_guard<InstrumentedMutex> lock(instance.processTableMutex);
+    for (const auto& core : instance.cpuCores) {
+        const Process* running = instance.processTable.get(core.running);
+        h.add(static_cast<uint64_t>(running ? running->pid : -1));
+        h.add(static_cast<uint64_t>(core.quantum_left));
+    }
+    instance.forEachProcess([&](const auto& p) {
+        h.add(static_cast<uint64_t>(p.pid));
+        h.add(p.name);
+        h.add(static_cast<uint64_t>(p.state()));
+        h.add(static_cast<uint64_t>(p.pc));
+        h.add(static_cast<uint64_t>(p.instructionCount()));
+        h.add(static_cast<uint64_t>(p.sleepCounter()));
+        if (p.busy_ticks > 0) h.add(static_cast<uint64_t>(p.busy_ticks)); // keeps digests of runs without one
+        h.add(static_cast<uint64_t>(p.logs.size()));
+        h.add(p.arrival_tick);
+        h.add(p.finish_tick);
+
+        // Sorted so the digest does not depend on container order
+        std::vector<std::pair<std::string, int>> symbols;
+        for (size_t slot = 0; slot < p.symbol_table.size(); ++slot) {
+            symbols.emplace_back(symbolName(p.symbol_table.idAt(slot)), static_cast<int>(slot * SymbolTable::VAR_SIZE));
+        }
+        std::sort(symbols.begin(), symbols.end());
+        for (const auto& [name, value] : symbols) {
+            h.add(name);
+            h.add(static_cast<uint64_t>(value));
+        }
+        if constexpr (std::is_same_v<std::decay_t<decltype(p)>, Process>) { // a finished process holds no pages
+            std::vector<std::pair<int, PageTableEntry>> pages(p.page_table.begin(), p.page_table.end());
+            std::sort(pages.begin(), pages.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (const auto& [page, pte] : pages) {
+                h.add(static_cast<uint64_t>(page));
+                h.add(static_cast<uint64_t>(pte.frame_num));
+                h.add((pte.valid ? 1u : 0u) | (pte.dirty ? 2u : 0u));
+                h.add(pte.last_accessed);
+            }
+        }
+    });
+    if (instance.memoryManager) instance.memoryManager->hashState(h);
+    return h.value();
+}
+
+// === Recorder ===
+bool RunRecorder::start(const std::string& file, std::string& error) {
+    if (!owner.initialized) {
+        error = "System not initialized. Type 'initialize' first.";
+        return false;
+    }
+    {
+        std::lock_guard<InstrumentedMutex> lock(owner.processTableMutex);
+        if (!owner.processTable.empty() || !owner.finishedProcesses.empty()) {
+            error = "Recording must start before any process is created.";
+            return false;
+        }
+    }
+    stop();
+    out.open(file, std::ios::trunc);
+    if (!out.is_open()) {
+        error = "cannot open " + file;
+        return false;
+    }
+    path = file;
+
+    out << "# csopesy recording\n";
+    for (const auto& [key, value] : configToSettings(owner.systemConfig)) {
+        out << "config " << key << " " << value << "\n";
+    }
+    out << "start " << owner.global_tick << "\n";
+    out.flush();
+    return true;
+}
+
+void RunRecorder::logCommand(unsigned long long tick, int session, const std::string& line) {
+    if (!out.is_open()) return;
+    out << "cmd " << tick << " " << session << " " << hex(stateDigest(owner)) << " " << line << "\n";
+    out.flush(); // a crash still leaves a replayable prefix
+}
+
+void RunRecorder::stop() {
+    if (!out.is_open()) return;
+    out << "end " << owner.global_tick << " " << hex(stateDigest(owner)) << "\n";
+    out.close();
+}
+
+// record <file> | record stop
+void recordCommand(const std::vector<std::string>& args) {
+    RunRecorder& recorder = emu().recorder;
+    if (args.size() != 2) {
+        consoleOut() << "Usage: record <file> | record stop\n";
+        return;
+    }
+    if (args[1] == "stop") {
+        if (!recorder.active()) {
+            consoleOut() << "Not recording.\n";
+            return;
+        }
+        recorder.stop();
+        consoleOut() << "Recording stopped at tick " << emu().global_tick << ".\n";
+        return;
+    }
+    std::string error;
+    if (!recorder.start(args[1], error)) {
+        consoleOut() << "Error: " << error << "\n";
+        return;
+    }
+    consoleOut() << "Recording to " << args[1] << " (seed " << emu().systemConfig.seed << ").\n";
+}
+
+// === Replay ===
+int runReplay(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Error: cannot open " << path << "\n";
+        return 1;
+    }
+
+    ConfigOverrides settings;
+    std::vector<RecordedCommand> commands;
+    unsigned long long startTick = 0, endTick = 0;
+    uint64_t expected = 0;
+    bool hasEnd = false;
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        bool valid = true;
+        if (kind == "config") {
+            // The value is the rest of the line, so one holding spaces survives the round trip
+            std::string key, value;
+            valid = static_cast<bool>(fields >> key) && std::getline(fields >> std::ws, value) && !value.empty();
+            settings.emplace_back(key, value);
+        }
+        else if (kind == "start") valid = static_cast<bool>(fields >> startTick);
+        else if (kind == "cmd") {
+            RecordedCommand c;
+            std::string digest;
+            valid = fields >> c.tick >> c.session >> digest && parseHex(digest, c.digest);
+            std::getline(fields >> std::ws, c.line);
+            commands.push_back(std::move(c));
+        }
+        else if (kind == "end") {
+            std::string digest;
+            valid = fields >> endTick >> digest && parseHex(digest, expected);
+            hasEnd = true;
+        }
+        else {
+            std::cerr << "Error: " << path << " line " << lineNo << ": unknown entry '" << kind << "'\n";
+            return 1;
+        }
+        if (!valid) {
+            std::cerr << "Error: " << path << " line " << lineNo << ": malformed '" << kind << "' entry\n";
+            return 1;
+        }
+    }
+    if (settings.empty()) {
+        std::cerr << "Error: " << path << " has no config\n";
+        return 1;
+    }
+
+    ConsoleOutput toStderr(std::cerr); // stdout is kept for the result line
+
+    Emulator instance;
+    instance.traceEnabled = false;
+    instance.throttleTicks = false;
+    instance.externalTicks = true;
+    instance.backingStorePath.clear();
+    EmulatorBinding bind(instance);
+
+    settings.emplace_back("metrics-interval", "0");
+    if (!initializeSystem("", settings)) {
+        std::cerr << "Error: recorded config is invalid\n";
+        return 1;
+    }
+    instance.global_tick = startTick;
+
+    const auto start = std::chrono::steady_clock::now();
+    auto advanceTo = [&](unsigned long long tick) {
+        while (instance.global_tick < tick) scheduler_loop_tick(true);
+    };
+
+    std::map<int, Session> sessions;
+    long firstDivergence = -1;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const auto& c = commands[i];
+        advanceTo(c.tick);
+        if (firstDivergence < 0 && (instance.global_tick != c.tick || stateDigest(instance) != c.digest)) {
+            firstDivergence = static_cast<long>(i);
+        }
+        std::lock_guard<InstrumentedMutex> tickLock(instance.tickMutex);
+        executeCommand(sessions[c.session], c.line, std::cerr);
+    }
+    if (hasEnd) advanceTo(endTick);
+    instance.autoCreateRunning.store(false);
+    instance.processGenerator.stop();
+
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t actual = stateDigest(instance);
+
+    bool match = hasEnd && actual == expected && firstDivergence < 0;
+    std::cout << std::fixed << std::setprecision(3)
+        << "{\"replay\":\"" << path << "\""
+        << ",\"commands\":" << commands.size()
+        << ",\"ticks\":" << instance.global_tick - startTick
+        << ",\"expected_digest\":\"" << (hasEnd ? hex(expected) : "") << "\""
+        << ",\"actual_digest\":\"" << hex(actual) << "\""
+        << ",\"match\":" << (match ? "true" : "false")
+        << ",\"wall_time_s\":" << wall << "}" << std::endl;
+
+    if (!hasEnd) std::cerr << "Warning: recording has no end line (run still in progress or crashed)\n";
+    if (firstDivergence >= 0) {
+        const auto& c = commands[static_cast<size_t>(firstDivergence)];
+        std::cerr << "Diverged before command " << firstDivergence + 1 << " (tick " << c.tick
+            << ", session " << c.session << "): " << c.line << "\n";
+    }
+    else if (hasEnd && actual != expected) {
+        std::cerr << "Diverged after the last command (end tick " << endTick << ")\n";
+    }
+    return match ? 0 : 3;
+}
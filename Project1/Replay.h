@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Emulator;
+
+// === State digest ===
+// FNV-1a over the simulation state that must match between a recorded run and its replay
+class StateHasher {
+public:
+    void add(uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 0x100000001B3ULL;
+        }
+    }
+    void add(const std::string& s) {
+        add(static_cast<uint64_t>(s.size()));
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 0x100000001B3ULL;
+        }
+    }
+    uint64_t value() const { return h; }
+
+private:
+    uint64_t h = 0xCBF29CE484222325ULL;
+};
+
+// Digest of an instance: tick, counters, cores, processes, page tables, RAM and backing store
+uint64_t stateDigest(Emulator& instance);
+
+// === Record / replay ===
+// A recording holds the effective config and seed, then one line per console or
+// control-socket command tagged with the global_tick it ran at and its session,
+// and finally the end tick and state digest:
+//   config <key> <value>
+//   start <tick>
+//   cmd <tick> <session> <digest> <command line>   (digest of the state before the command)
+//   end <tick> <digest>
+// Commands run between ticks (see Emulator::tickMutex), so replaying them at the
+// same ticks on a fresh instance reproduces the run.
+class RunRecorder {
+public:
+    explicit RunRecorder(Emulator& owner) : owner(owner) {}
+
+    // Needs an initialized instance with an empty process table
+    bool start(const std::string& path, std::string& error);
+    void logCommand(unsigned long long tick, int session, const std::string& line);
+    void stop(); // writes the end line; no-op if not recording
+    bool active() const { return out.is_open(); }
+
+private:
+    Emulator& owner;
+    std::ofstream out;
+    std::string path;
+};
+
+// record <file> | record stop
+void recordCommand(const std::vector<std::string>& args);
+
+// Replays a recording headless and unthrottled; returns 0 if the final digest matches
+int runReplay(const std::string& path);
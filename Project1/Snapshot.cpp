@@ -0,0 +1,383 @@
+#include "Snapshot.h"
+#include "Emulator.h"
+#include "Instruction.h"
+#include "ProgramLoader.h"
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+    const char MAGIC[8] = { 'C', 'S', 'O', 'P', 'S', 'N', 'A', 'P' };
+    // 2: finished processes saved apart from the table; 3: busy ticks; 4: finished processes as compact records
+    constexpr uint32_t VERSION = 4;
+
+    void writeProcess(SnapshotWriter& out, const Process& p, std::unordered_map<const Instruction*, uint32_t>& ids) {
+        out.str(p.name);
+        out.i32(p.pid);
+        out.u8(static_cast<uint8_t>(p.state()));
+        out.i32(p.pc);
+        out.i32(static_cast<int32_t>(p.symbol_table.size() * SymbolTable::VAR_SIZE)); // next free address
+        out.i32(p.sleepCounter());
+        out.i32(p.quantum_used);
+        out.u8(p.needs_cpu ? 1 : 0);
+        out.i32(p.busy_ticks);
+        out.u64(p.arrival_tick);
+        out.u64(p.finish_tick);
+        out.i32(p.memory_required);
+
+        out.u32(static_cast<uint32_t>(p.program->size()));
+        for (const auto& inst : *p.program) out.u32(ids.at(inst.get()));
+
+        out.u32(static_cast<uint32_t>(p.logs.size()));
+        for (const auto& log : p.logs) out.str(log);
+
+        out.u32(static_cast<uint32_t>(p.symbol_table.size()));
+        for (size_t slot = 0; slot < p.symbol_table.size(); ++slot) {
+            out.str(symbolName(p.symbol_table.idAt(slot)));
+            out.i32(static_cast<int32_t>(slot * SymbolTable::VAR_SIZE));
+        }
+
+        out.u32(static_cast<uint32_t>(p.page_table.size()));
+        for (const auto& [page, pte] : p.page_table) {
+            out.i32(page);
+            out.i32(pte.frame_num);
+            out.u8((pte.valid ? 1 : 0) | (pte.dirty ? 2 : 0) | (pte.paged_out ? 4 : 0));
+            out.u64(pte.last_accessed);
+        }
+    }
+
+    bool readProcess(SnapshotReader& in, Process& p, const std::vector<std::shared_ptr<Instruction>>& programs) {
+        p.name = in.str();
+        p.pid = in.i32();
+        p.setState(static_cast<ProcessState>(in.u8()));
+        p.pc = in.i32();
+        in.i32(); // next free symbol address; implied by the symbol count
+        p.setSleepCounter(in.i32());
+        p.quantum_used = in.i32();
+        p.needs_cpu = in.u8() != 0;
+        p.busy_ticks = in.i32();
+        p.arrival_tick = in.u64();
+        p.finish_tick = in.u64();
+        p.memory_required = in.i32();
+
+        uint32_t count = in.u32();
+        if (!in.fits(count, 4)) return false;
+        InstructionList code;
+        code.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t id = in.u32();
+            if (id >= programs.size()) return false;
+            code.push_back(programs[id]);
+        }
+        p.program = ProgramImage::intern(std::move(code)); // identical programs share one image again
+
+        count = in.u32();
+        if (!in.fits(count, 4)) return false;
+        for (uint32_t i = 0; i < count; ++i) p.logs.emplace_back(in.str());
+
+        count = in.u32();
+        if (!in.fits(count, 8) || count > SymbolTable::CAPACITY) return false;
+        std::vector<std::pair<int, std::string>> symbols; // (address, name)
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string name = in.str();
+            symbols.emplace_back(in.i32(), std::move(name));
+        }
+        std::sort(symbols.begin(), symbols.end());
+        p.symbol_table.clear();
+        for (const auto& [addr, name] : symbols) {
+            // Slots fill in order, so the addresses must be 0, 2, 4, ...
+            if (p.symbol_table.declare(internSymbol(name)) != addr) return false;
+        }
+
+        count = in.u32();
+        if (!in.fits(count, 17)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            int page = in.i32();
+            PageTableEntry& pte = p.page_table[page];
+            pte.frame_num = in.i32();
+            uint8_t flags = in.u8();
+            pte.valid = (flags & 1) != 0;
+            pte.dirty = (flags & 2) != 0;
+            pte.paged_out = (flags & 4) != 0;
+            pte.last_accessed = in.u64();
+        }
+        return in.good();
+    }
+
+    void writeFinished(SnapshotWriter& out, const FinishedProcess& p) {
+        out.str(p.name);
+        out.i32(p.pid);
+        out.u8(static_cast<uint8_t>(p.state()));
+        out.i32(p.pc);
+        out.u32(static_cast<uint32_t>(p.instruction_count));
+        out.i32(p.sleep_counter);
+        out.i32(p.busy_ticks);
+        out.u64(p.arrival_tick);
+        out.u64(p.finish_tick);
+        out.i32(p.memory_required);
+
+        out.u32(static_cast<uint32_t>(p.logs.size()));
+        for (const auto& log : p.logs) out.str(log);
+
+        out.u32(static_cast<uint32_t>(p.symbol_table.size()));
+        for (size_t slot = 0; slot < p.symbol_table.size(); ++slot) out.str(symbolName(p.symbol_table.idAt(slot)));
+    }
+
+    bool readFinished(SnapshotReader& in, FinishedProcess& p) {
+        p.name = in.str();
+        p.pid = in.i32();
+        p.end_state = static_cast<ProcessState>(in.u8());
+        p.pc = in.i32();
+        p.instruction_count = in.u32();
+        p.sleep_counter = in.i32();
+        p.busy_ticks = in.i32();
+        p.arrival_tick = in.u64();
+        p.finish_tick = in.u64();
+        p.memory_required = in.i32();
+
+        uint32_t count = in.u32();
+        if (!in.fits(count, 4)) return false;
+        for (uint32_t i = 0; i < count; ++i) p.logs.emplace_back(in.str());
+
+        // Names in slot order; the slot gives the address
+        count = in.u32();
+        if (!in.fits(count, 4) || count > SymbolTable::CAPACITY) return false;
+        p.symbol_table.clear();
+        for (uint32_t i = 0; i < count; ++i) p.symbol_table.declare(internSymbol(in.str()));
+        return in.good();
+    }
+}
+
+bool saveSnapshot(const std::string& path, std::string& error) {
+    Emulator& sim = emu();
+    if (!sim.initialized) {
+        error = "System not initialized. Type 'initialize' first.";
+        return false;
+    }
+
+    SnapshotWriter out;
+    out.raw(MAGIC, sizeof(MAGIC));
+    out.u32(VERSION);
+
+    ConfigOverrides settings = configToSettings(sim.systemConfig);
+    out.u32(static_cast<uint32_t>(settings.size()));
+    for (const auto& [key, value] : settings) {
+        out.str(key);
+        out.str(value);
+    }
+
+    out.u64(sim.global_tick);
+    out.u64(static_cast<uint64_t>(sim.nextPID));
+    out.u64(sim.rrCursor);
+    out.u64(sim.instructionsExecuted);
+    out.u64(sim.busyCoreTicks);
+    out.u8(sim.autoCreateRunning.load() ? 1 : 0);
+    out.u64(sim.processGenerator.nextToAdmit());
+
+    // Memory first: MemoryManager takes mem_mutex before processTableMutex, so never nest them here
+    SnapshotWriter memory;
+    sim.memoryManager->saveState(memory);
+
+    {
+        std::lock_guard<InstrumentedMutex> lock(sim.processTableMutex);
+
+        // Instructions are stored once each (as text) and referenced by index, so shared programs stay shared
+        std::unordered_map<const Instruction*, uint32_t> ids;
+        std::vector<const Instruction*> unique;
+        for (const auto& p : sim.processTable) { // finished processes keep no program
+            for (const auto& inst : *p.program) {
+                if (ids.emplace(inst.get(), static_cast<uint32_t>(unique.size())).second) unique.push_back(inst.get());
+            }
+        }
+        out.u32(static_cast<uint32_t>(unique.size()));
+        for (const Instruction* inst : unique) out.str(inst->toString());
+
+        out.u32(static_cast<uint32_t>(sim.processTable.size()));
+        for (const auto& p : sim.processTable) writeProcess(out, p, ids);
+        out.u32(static_cast<uint32_t>(sim.finishedProcesses.size()));
+        for (const auto& p : sim.finishedProcesses) writeFinished(out, p);
+
+        out.u32(static_cast<uint32_t>(sim.cpuCores.size()));
+        for (const auto& core : sim.cpuCores) {
+            const Process* running = sim.processTable.get(core.running);
+            out.i32(running ? running->pid : -1);
+            out.i32(core.quantum_left);
+        }
+    }
+    out.raw(memory.bytes().data(), memory.bytes().size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    file.write(out.bytes().data(), static_cast<std::streamsize>(out.bytes().size()));
+    if (!file.good()) {
+        error = "write failed for " + path;
+        return false;
+    }
+    return true;
+}
+
+bool loadSnapshot(const std::string& path, std::string& error) {
+    MappedFile file;
+    if (!file.open(path, error)) return false;
+    std::string_view bytes = file.view();
+    SnapshotReader in(bytes.data(), bytes.size());
+
+    char magic[sizeof(MAGIC)] = {};
+    in.raw(magic, sizeof(magic));
+    if (!in.good() || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || in.u32() != VERSION) {
+        error = path + " is not a snapshot (or is from another version)";
+        return false;
+    }
+
+    // Decode everything that does not need the new instance before touching live state
+    ConfigOverrides settings;
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.good(); ++i) {
+        std::string key = in.str();
+        settings.emplace_back(key, in.str());
+    }
+    unsigned long long tick = in.u64();
+    int nextPID = static_cast<int>(in.u64());
+    size_t rrCursor = static_cast<size_t>(in.u64());
+    unsigned long long instructions = in.u64();
+    unsigned long long busyCoreTicks = in.u64();
+    bool autoCreate = in.u8() != 0;
+    unsigned long long generatorIndex = in.u64();
+
+    count = in.u32();
+    std::vector<std::shared_ptr<Instruction>> programs;
+    if (in.fits(count, 4)) programs.reserve(count);
+    for (uint32_t i = 0; i < count && in.good(); ++i) {
+        std::string text = in.str();
+        auto inst = parseInstruction(text);
+        if (!inst) {
+            error = "corrupt instruction in snapshot: " + text;
+            return false;
+        }
+        programs.push_back(std::move(inst));
+    }
+
+    std::deque<Process> processes;
+    count = in.u32();
+    for (uint32_t i = 0; i < count && in.good(); ++i) {
+        Process p(emu().processTable.resource());
+        if (!readProcess(in, p, programs)) {
+            error = path + " has a corrupt process entry";
+            return false;
+        }
+        processes.push_back(std::move(p));
+    }
+
+    FinishedProcesses finished;
+    count = in.u32();
+    for (uint32_t i = 0; i < count && in.good(); ++i) {
+        FinishedProcess p(emu().processTable.resource()); // logs on the table's pool, as retirement leaves them
+        if (!readFinished(in, p)) {
+            error = path + " has a corrupt process entry";
+            return false;
+        }
+        finished.push_back(std::move(p));
+    }
+
+    std::vector<std::pair<int, int>> cores;
+    count = in.u32();
+    if (in.fits(count, 8)) {
+        for (uint32_t i = 0; i < count; ++i) {
+            int pid = in.i32();
+            cores.emplace_back(pid, in.i32());
+        }
+    }
+    if (!in.good()) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    // Apply: stop producing, rebuild the instance from the saved config, then overwrite its state
+    Emulator& sim = emu();
+    sim.autoCreateRunning.store(false);
+    sim.processGenerator.stop();
+    if (!initializeSystem("", settings)) {
+        error = "snapshot config is invalid";
+        return false;
+    }
+    if (!sim.memoryManager->loadState(in) || !in.atEnd() || cores.size() != sim.cpuCores.size()) {
+        // The instance was already re-initialized; leave it empty rather than half-restored
+        std::lock_guard<InstrumentedMutex> lock(sim.processTableMutex);
+        sim.processTable.clear();
+        sim.finishedProcesses.clear();
+        for (auto& core : sim.cpuCores) core.running = ProcessHandle{};
+        sim.memoryManager = std::make_unique<MemoryManager>(sim.memoryManager->getTotalFrames(),
+            sim.systemConfig.mem_per_frame, sim.backingStorePath);
+        error = path + " does not match its own config; the system was left empty";
+        return false;
+    }
+
+    {
+        std::lock_guard<InstrumentedMutex> lock(sim.processTableMutex);
+        sim.processTable.clear();
+        for (auto& p : processes) sim.processTable.insert(std::move(p));
+        sim.finishedProcesses = std::move(finished);
+        for (size_t i = 0; i < cores.size(); ++i) {
+            sim.cpuCores[i].running = cores[i].first < 0 ? ProcessHandle{} : sim.processTable.find(cores[i].first);
+            sim.cpuCores[i].quantum_left = cores[i].second;
+        }
+        sim.global_tick = tick;
+        sim.nextPID = nextPID;
+        sim.rrCursor = rrCursor;
+        sim.instructionsExecuted = instructions;
+        sim.busyCoreTicks = busyCoreTicks;
+    }
+    sim.memoryManager->relinkOwners(sim.processTable); // takes mem_mutex, so outside the table lock
+
+    sim.processGenerator.resumeAt(generatorIndex);
+    if (autoCreate) {
+        sim.autoCreateRunning.store(true);
+        sim.processGenerator.start();
+    }
+    return true;
+}
+
+// checkpoint <file>
+void checkpointCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        consoleOut() << "Usage: checkpoint <file>\n";
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (!saveSnapshot(args[1], error)) {
+        consoleOut() << "Error: " << error << "\n";
+        return;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    consoleOut() << "Checkpoint written to " << args[1] << " at tick " << emu().global_tick
+        << " (" << ms << " ms, state " << std::hex << stateDigest(emu()) << std::dec << ").\n";
+}
+
+// restore <file>
+void restoreCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        consoleOut() << "Usage: restore <file>\n";
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (!loadSnapshot(args[1], error)) {
+        consoleOut() << "Error: " << error << "\n";
+        return;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    consoleOut() << "Restored " << args[1] << " at tick " << emu().global_tick << " with "
+        << emu().processTable.size() + emu().finishedProcesses.size() << " processes (" << ms << " ms, state "
+        << std::hex << stateDigest(emu()) << std::dec << ").\n";
+
+    // Resume if there is anything to run
+    bool active = emu().autoCreateRunning.load();
+    if (emu().processTable.anyActive()) active = true;
+    if (active) ensureSchedulerActive();
+}
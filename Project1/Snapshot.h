@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// === Binary snapshot encoding ===
+// Native-endian, length-prefixed fields appended to one buffer that is written
+// (and read back through a memory map) in a single bulk operation.
+class SnapshotWriter {
+public:
+    void u8(uint8_t v) { raw(&v, 1); }
+    void u32(uint32_t v) { raw(&v, 4); }
+    void u64(uint64_t v) { raw(&v, 8); }
+    void i32(int32_t v) { raw(&v, 4); }
+    void str(std::string_view s) {
+        u32(static_cast<uint32_t>(s.size()));
+        raw(s.data(), s.size());
+    }
+    void raw(const void* data, size_t n) { buf.append(static_cast<const char*>(data), n); }
+    const std::string& bytes() const { return buf; }
+
+private:
+    std::string buf;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : p(data), end(data + size) {}
+
+    uint8_t u8() { uint8_t v = 0; raw(&v, 1); return v; }
+    uint32_t u32() { uint32_t v = 0; raw(&v, 4); return v; }
+    uint64_t u64() { uint64_t v = 0; raw(&v, 8); return v; }
+    int32_t i32() { int32_t v = 0; raw(&v, 4); return v; }
+    std::string str() {
+        uint32_t n = u32();
+        if (!take(n)) return {};
+        std::string s(p - n, n);
+        return s;
+    }
+    void raw(void* out, size_t n) {
+        if (take(n)) std::memcpy(out, p - n, n);
+    }
+    // Guards element counts read from the file before they size a container
+    bool fits(uint64_t count, size_t elementSize) {
+        if (count > static_cast<uint64_t>(end - p) / (elementSize ? elementSize : 1)) ok = false;
+        return ok;
+    }
+    bool good() const { return ok; }
+    bool atEnd() const { return p == end; }
+
+private:
+    bool take(size_t n) {
+        if (!ok || static_cast<size_t>(end - p) < n) {
+            ok = false;
+            return false;
+        }
+        p += n;
+        return true;
+    }
+
+    const char* p;
+    const char* end;
+    bool ok = true;
+};
+
+// === Checkpoint / restore ===
+// A snapshot holds the config, counters, generator position, every process
+// (program, symbols, page table, logs), core assignments, the frame table, RAM
+// and the backing store of the instance bound to this thread.
+bool saveSnapshot(const std::string& path, std::string& error);
+bool loadSnapshot(const std::string& path, std::string& error);
+
+// checkpoint <file> / restore <file>
+void checkpointCommand(const std::vector<std::string>& args);
+void restoreCommand(const std::vector<std::string>& args);
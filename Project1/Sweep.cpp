@@ -0,0 +1,237 @@
+#include "Sweep.h"
+#include "Emulator.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    struct SweepRun {
+        ConfigOverrides settings;
+        RunSummary summary;
+        bool ok = false;
+        std::string error; // why the run failed, for its row in the table
+    };
+
+    // The last line a failed run printed, which names what went wrong
+    std::string lastLine(const std::string& output) {
+        size_t end = output.find_last_not_of("\n");
+        if (end == std::string::npos) return {};
+        size_t begin = output.rfind('\n', end);
+        begin = begin == std::string::npos ? 0 : begin + 1;
+        return output.substr(begin, end + 1 - begin);
+    }
+
+    bool parseNumber(const std::string& text, long long& out) {
+        try {
+            size_t used = 0;
+            out = std::stoll(text, &used);
+            return used == text.size();
+        }
+        catch (...) {
+            return false;
+        }
+    }
+}
+
+bool parseSweepAxis(const std::string& spec, SweepAxis& out, std::string& error) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0 || eq + 1 == spec.size()) {
+        error = "--sweep expects key=values, got: " + spec;
+        return false;
+    }
+    out.key = spec.substr(0, eq);
+    out.values.clear();
+    std::string values = spec.substr(eq + 1);
+
+    size_t dots = values.find("..");
+    if (dots == std::string::npos) {
+        std::stringstream list(values);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            if (!item.empty()) out.values.push_back(item);
+        }
+    }
+    else {
+        std::string loText = values.substr(0, dots);
+        std::string rest = values.substr(dots + 2);
+        char op = '+';
+        std::string stepText = "1";
+        size_t opPos = rest.find_first_of("+*");
+        if (opPos != std::string::npos) {
+            op = rest[opPos];
+            stepText = rest.substr(opPos + 1);
+            rest = rest.substr(0, opPos);
+        }
+
+        long long lo = 0, hi = 0, step = 0;
+        if (!parseNumber(loText, lo) || !parseNumber(rest, hi) || !parseNumber(stepText, step) ||
+            lo > hi || (op == '+' && step <= 0) || (op == '*' && (step <= 1 || lo <= 0))) {
+            error = "Invalid sweep range for " + out.key + ": " + values;
+            return false;
+        }
+        for (long long v = lo; v <= hi; v = (op == '+') ? v + step : v * step) {
+            out.values.push_back(std::to_string(v));
+        }
+    }
+
+    if (out.values.empty()) {
+        error = "No values to sweep for " + out.key;
+        return false;
+    }
+    return true;
+}
+
+int runSweep(const HeadlessOptions& baseOpts) {
+    HeadlessOptions opts = baseOpts;
+    opts.trace = false;
+
+    // Cartesian product of every axis, first axis varying slowest
+    std::vector<SweepRun> runs(1);
+    for (const auto& axis : opts.sweep) {
+        std::vector<SweepRun> expanded;
+        expanded.reserve(runs.size() * axis.values.size());
+        for (const auto& run : runs) {
+            for (const auto& value : axis.values) {
+                SweepRun next = run;
+                next.settings.emplace_back(axis.key, value);
+                expanded.push_back(std::move(next));
+            }
+        }
+        runs = std::move(expanded);
+    }
+
+    // One seed for every run: the config's, --seed, or a fresh one shared by all
+    if (!opts.seeded) {
+        Emulator scratch;
+        EmulatorBinding bind(scratch);
+        std::ostringstream messages;
+        bool loaded = false;
+        {
+            ConsoleOutput quiet(messages);
+            loaded = loadConfigFile(opts.configFile);
+        }
+        if (!loaded) {
+            std::cerr << messages.str() << "Error: could not load " << opts.configFile << "\n";
+            return 1;
+        }
+        opts.seed = scratch.systemConfig.has_seed ? scratch.systemConfig.seed
+            : (static_cast<unsigned long long>(std::random_device{}()) << 32) | std::random_device{}();
+        opts.seeded = true;
+    }
+
+    // Every run's config is loaded once before any of them starts, so an unknown key or
+    // a value the config rejects stops the sweep instead of failing runs one by one
+    for (const auto& run : runs) {
+        Emulator scratch;
+        EmulatorBinding bind(scratch);
+        std::ostringstream messages;
+        bool loaded = false;
+        {
+            ConsoleOutput quiet(messages);
+            loaded = loadConfigFile(opts.configFile, run.settings);
+        }
+        if (!loaded) {
+            std::cerr << lastLine(messages.str()) << "\nError: cannot sweep";
+            for (const auto& [key, value] : run.settings) std::cerr << " " << key << "=" << value;
+            std::cerr << "\n";
+            return 1;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(opts.jobs > 0 ? static_cast<size_t>(opts.jobs) : 0);
+        std::vector<std::future<void>> pending;
+        pending.reserve(runs.size());
+        for (auto& run : runs) {
+            pending.push_back(pool.submit([&run, &opts]() {
+                // Each run prints into its own buffer; a failure keeps the last line
+                std::ostringstream output;
+                ConsoleOutput capture(output);
+                try {
+                    Emulator instance;
+                    instance.backingStorePath.clear(); // runs share the working directory
+                    EmulatorBinding bind(instance);
+                    run.ok = runSimulation(opts, run.settings, run.summary);
+                    if (!run.ok) run.error = lastLine(output.str());
+                }
+                catch (const std::exception& e) {
+                    run.ok = false;
+                    run.error = std::string("Error: ") + e.what();
+                }
+            }));
+        }
+        for (auto& f : pending) f.get();
+    }
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream csv;
+    if (!opts.sweepCsv.empty()) {
+        csv.open(opts.sweepCsv);
+        if (!csv.is_open()) std::cerr << "Warning: cannot open " << opts.sweepCsv << "\n";
+    }
+
+    // Each axis column fits its key and its longest value
+    std::vector<int> widths;
+    for (const auto& axis : opts.sweep) {
+        int width = std::max<int>(static_cast<int>(axis.key.size()), 6);
+        for (const auto& value : axis.values) width = std::max<int>(width, static_cast<int>(value.size()));
+        widths.push_back(width + 2);
+    }
+
+    std::ostringstream table;
+    table << std::fixed;
+    for (size_t a = 0; a < opts.sweep.size(); ++a) {
+        table << std::left << std::setw(widths[a]) << opts.sweep[a].key;
+        if (csv.is_open()) csv << opts.sweep[a].key << ",";
+    }
+    table << std::right << std::setw(10) << "ticks" << std::setw(10) << "finished"
+        << std::setw(14) << "procs/1kTick" << std::setw(14) << "turnaround"
+        << std::setw(8) << "util%" << std::setw(14) << "faults/1kIns" << std::setw(10) << "wall(s)" << "\n";
+    if (csv.is_open()) {
+        csv << "ticks,finished,processes,throughput_per_1k_ticks,mean_turnaround_ticks,"
+            << "cpu_utilization,page_faults_per_1k_instructions,wall_time_s\n";
+    }
+
+    const SweepRun* best = nullptr;
+    auto throughput = [](const RunSummary& s) { return s.ticks ? 1000.0 * s.finished / s.ticks : 0.0; };
+    for (const auto& run : runs) {
+        for (size_t a = 0; a < opts.sweep.size(); ++a) {
+            table << std::left << std::setw(widths[a]) << run.settings[a].second;
+            if (csv.is_open()) csv << run.settings[a].second << ",";
+        }
+        if (!run.ok) {
+            table << "  (" << (run.error.empty() ? "run failed" : run.error) << ")\n";
+            if (csv.is_open()) csv << ",,,,,,,\n";
+            continue;
+        }
+        const RunSummary& s = run.summary;
+        double faultRate = s.instructions ? 1000.0 * s.pageFaults / s.instructions : 0.0;
+        table << std::right << std::setw(10) << s.ticks
+            << std::setw(10) << (std::to_string(s.finished) + "/" + std::to_string(s.processes))
+            << std::setw(14) << std::setprecision(3) << throughput(s)
+            << std::setw(14) << std::setprecision(1) << s.meanTurnaround
+            << std::setw(8) << s.utilization * 100.0
+            << std::setw(14) << std::setprecision(2) << faultRate
+            << std::setw(10) << std::setprecision(3) << s.wallSeconds << "\n";
+        if (csv.is_open()) {
+            csv << s.ticks << "," << s.finished << "," << s.processes << "," << throughput(s) << ","
+                << s.meanTurnaround << "," << s.utilization << "," << faultRate << "," << s.wallSeconds << "\n";
+        }
+        if (!best || throughput(s) > throughput(best->summary)) best = &run;
+    }
+
+    std::cout << table.str();
+    if (best) {
+        std::cout << "Best throughput:";
+        for (const auto& [key, value] : best->settings) std::cout << " " << key << "=" << value;
+        std::cout << "\n";
+    }
+    std::cout << runs.size() << " runs, seed " << opts.seed << ", " << std::setprecision(2) << wall << "s\n";
+    return 0;
+}
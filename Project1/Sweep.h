@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+#include "headless.h"
+
+// === Parameter sweep ===
+// Runs the headless simulation once per combination of the swept config values,
+// each on its own Emulator instance, spread over a thread pool. Every run uses
+// the same seed so only the swept values differ.
+
+// Parses "key=a,b,c", "key=lo..hi", "key=lo..hi+step" or "key=lo..hi*factor"
+bool parseSweepAxis(const std::string& spec, SweepAxis& out, std::string& error);
+
+// Prints the comparison table to stdout (and opts.sweepCsv); returns the process exit code
+int runSweep(const HeadlessOptions& opts);
@@ -0,0 +1,62 @@
+#include "Symbols.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    // Names are appended to fixed-size chunks that never move, and a name is never
+    // changed once written. A chunk is published with a release store, and an id only
+    // reaches another thread after internSymbol returned it, so symbolName reads
+    // without taking any lock.
+    constexpr size_t CHUNK_BITS = 10;
+    constexpr size_t CHUNK_SIZE = size_t{ 1 } << CHUNK_BITS;
+    constexpr size_t MAX_CHUNKS = 4096; // 4M distinct names
+
+    struct Interner {
+        std::shared_mutex mutex; // guards ids and appends
+        std::unordered_map<std::string_view, SymbolId> ids;
+        std::deque<std::unique_ptr<std::string[]>> owned;
+        std::atomic<std::string*> chunks[MAX_CHUNKS] = {};
+        size_t count = 0;
+    };
+
+    Interner& interner() {
+        static Interner instance;
+        return instance;
+    }
+}
+
+SymbolId internSymbol(std::string_view name) {
+    Interner& table = interner();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name); // another thread may have added it meanwhile
+    if (it != table.ids.end()) return it->second;
+
+    const size_t chunk = table.count >> CHUNK_BITS;
+    if (chunk >= MAX_CHUNKS) throw std::length_error("too many distinct variable names");
+    if ((table.count & (CHUNK_SIZE - 1)) == 0) {
+        table.owned.push_back(std::make_unique<std::string[]>(CHUNK_SIZE));
+        table.chunks[chunk].store(table.owned.back().get(), std::memory_order_release);
+    }
+    std::string& slot = table.chunks[chunk].load(std::memory_order_relaxed)[table.count & (CHUNK_SIZE - 1)];
+    slot = name;
+    SymbolId id = static_cast<SymbolId>(table.count++);
+    table.ids.emplace(slot, id);
+    return id;
+}
+
+const std::string& symbolName(SymbolId id) {
+    const std::string* chunk = interner().chunks[id >> CHUNK_BITS].load(std::memory_order_acquire);
+    return chunk[id & (CHUNK_SIZE - 1)];
+}
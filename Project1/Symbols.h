@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// === Variable names ===
+// Every variable name is interned once into a process-wide table, so instructions and
+// symbol tables carry small ids instead of strings. Only names go in; literals and
+// addresses stay with their instructions. Safe to call from any thread, and symbolName
+// takes no lock, so formatting trace lines never contends with parsing.
+using SymbolId = uint32_t;
+
+SymbolId internSymbol(std::string_view name);
+const std::string& symbolName(SymbolId id);
+
+// === Per-process symbol table ===
+// The 64-byte symbol table in page 0: 32 two-byte slots, filled in declaration order,
+// so slot i always lives at address i * VAR_SIZE. Lookups are a linear probe over at
+// most 32 ids.
+class SymbolTable {
+public:
+    static constexpr size_t VAR_SIZE = 2;
+    static constexpr size_t CAPACITY = 64 / VAR_SIZE;
+
+    // Address of the variable, or -1 if it was never declared
+    int find(SymbolId id) const {
+        for (size_t i = 0; i < count; ++i) {
+            if (ids[i] == id) return static_cast<int>(i * VAR_SIZE);
+        }
+        return -1;
+    }
+
+    // Address of the variable, taking the next free slot if it is new; -1 when full
+    int declare(SymbolId id) {
+        int addr = find(id);
+        if (addr >= 0) return addr;
+        if (count == CAPACITY) return -1;
+        ids[count] = id;
+        return static_cast<int>(count++ * VAR_SIZE);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    SymbolId idAt(size_t slot) const { return ids[slot]; }
+    void clear() { count = 0; }
+
+private:
+    std::array<SymbolId, CAPACITY> ids{};
+    size_t count = 0;
+};
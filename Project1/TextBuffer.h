@@ -0,0 +1,43 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+// === Text buffer ===
+// Appends text and integers (std::to_chars) into caller-provided storage without
+// allocating. Text past the capacity is dropped, but required() still counts it,
+// so a caller can retry with a buffer of the right size.
+class TextBuffer {
+public:
+    TextBuffer(char* data, size_t capacity) : data(data), capacity(capacity) {}
+
+    void append(std::string_view text) {
+        if (length < capacity) {
+            size_t n = text.size() < capacity - length ? text.size() : capacity - length;
+            std::memcpy(data + length, text.data(), n);
+        }
+        length += text.size();
+    }
+
+    void append(char c) {
+        if (length < capacity) data[length] = c;
+        length++;
+    }
+
+    template <typename Int>
+    void appendInt(Int value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+    }
+
+    bool overflowed() const { return length > capacity; }
+    size_t required() const { return length; }
+    std::string_view view() const { return std::string_view(data, overflowed() ? capacity : length); }
+
+private:
+    char* data;
+    size_t capacity;
+    size_t length = 0;
+};
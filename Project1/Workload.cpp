@@ -0,0 +1,255 @@
+#include "Workload.h"
+#include "Instruction.h"
+#include "Emulator.h"
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+// Indexed by Opcode; NOP has no name here since it is never generated
+static const char* OPCODE_NAMES[] = { "DECLARE", "ADD", "SUBTRACT", "PRINT", "SLEEP", "FOR", "READ", "WRITE",
+    nullptr, "MEMSET", "MEMCPY" };
+static_assert(std::size(OPCODE_NAMES) == static_cast<size_t>(Opcode::COUNT), "one name per opcode");
+static const char* BASE_VARIABLES[] = { "x", "y", "sum", "diff", "val" };
+
+// Produces the addresses touched by READ/WRITE for one generated program
+class AddressStream {
+public:
+    AddressStream(const WorkloadProfile& profile, int memSize, Rng& rng)
+        : profile(profile), memSize(std::max(memSize, 1)), rng(rng) {
+        if (profile.addresses == AddressPattern::ZIPF) {
+            int frame = static_cast<int>(std::max<size_t>(emu().systemConfig.mem_per_frame, 1));
+            pageSize = std::min(frame, this->memSize);
+            int pages = std::max(this->memSize / pageSize, 1);
+            cdf.resize(pages);
+            double total = 0.0;
+            for (int rank = 0; rank < pages; ++rank) {
+                total += 1.0 / std::pow(rank + 1.0, profile.zipf_exponent);
+                cdf[rank] = total;
+            }
+            for (auto& c : cdf) c /= total;
+        }
+    }
+
+    int next() {
+        switch (profile.addresses) {
+        case AddressPattern::SEQUENTIAL:
+            cursor = (cursor + 2) % memSize;
+            return cursor;
+        case AddressPattern::STRIDED:
+            cursor = (cursor + profile.stride) % memSize;
+            return cursor;
+        case AddressPattern::ZIPF: {
+            double u = rng.uniform();
+            int page = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+            page = std::min(page, static_cast<int>(cdf.size()) - 1);
+            return std::min(page * pageSize + static_cast<int>(rng.below(pageSize)), memSize - 1);
+        }
+        case AddressPattern::UNIFORM:
+        default:
+            return static_cast<int>(rng.below(memSize));
+        }
+    }
+
+private:
+    const WorkloadProfile& profile;
+    int memSize;
+    Rng& rng;
+    int cursor = 0;
+    int pageSize = 1;
+    std::vector<double> cdf;
+};
+
+static std::string variableName(int index) {
+    if (index < 5) return BASE_VARIABLES[index];
+    std::string name = "v";
+    name += std::to_string(index);
+    return name;
+}
+
+void WorkloadProfile::generate(InstructionList& ins, int count, int memSize, Rng& rng) const {
+    ins.reserve(ins.size() + count);
+
+    int totalWeight = 0;
+    for (int w : weights) totalWeight += w;
+    if (totalWeight <= 0) return;
+
+    AddressStream addresses(*this, memSize, rng);
+    auto pickVar = [&]() { return variableName(static_cast<int>(rng.below(variables))); };
+
+    // Draws an opcode by weight, optionally excluding FOR (no nested loops)
+    auto pickOpcode = [&](bool allowFor) {
+        while (true) {
+            int roll = static_cast<int>(rng.below(totalWeight));
+            int op = 0;
+            while (roll >= weights[op]) roll -= weights[op++];
+            if (allowFor || static_cast<Opcode>(op) != Opcode::FOR) return static_cast<Opcode>(op);
+            if (totalWeight == weights[static_cast<int>(Opcode::FOR)]) return Opcode::PRINT;
+        }
+    };
+
+    // MEMSET/MEMCPY ranges start at the next address, moved down to fit in memory
+    auto bulkLength = [&]() { return std::min(static_cast<int>(rng.range(bulk_min, bulk_max)), std::max(memSize, 1)); };
+    auto bulkStart = [&](int length) { return std::min(addresses.next(), std::max(memSize - length, 0)); };
+
+    // Instructions are constructed directly; only FOR bodies go through text
+    auto makeInstruction = [&](Opcode op) -> std::shared_ptr<Instruction> {
+        switch (op) {
+        case Opcode::DECLARE:
+            return std::make_shared<DeclareInstruction>(pickVar(), static_cast<int>(rng.range(0, value_max)));
+        case Opcode::ADD: {
+            std::string target = pickVar(), a = pickVar();
+            return std::make_shared<AddInstruction>(target, a, pickVar());
+        }
+        case Opcode::SUBTRACT: {
+            std::string target = pickVar(), a = pickVar();
+            return std::make_shared<SubtractInstruction>(target, a, pickVar());
+        }
+        case Opcode::PRINT: {
+            std::string var = pickVar();
+            return std::make_shared<PrintInstruction>("'Value of " + var + ": ' + " + var);
+        }
+        case Opcode::SLEEP:
+            return std::make_shared<SleepInstruction>(static_cast<int>(rng.range(sleep_min, sleep_max)));
+        case Opcode::READ: {
+            std::string addr = std::to_string(addresses.next());
+            return std::make_shared<ReadInstruction>(addr, pickVar());
+        }
+        case Opcode::WRITE: {
+            std::string addr = std::to_string(addresses.next());
+            return std::make_shared<WriteInstruction>(addr, pickVar());
+        }
+        case Opcode::MEMSET: {
+            int length = bulkLength();
+            std::string addr = std::to_string(bulkStart(length));
+            return std::make_shared<MemsetInstruction>(addr, pickVar(), std::to_string(length));
+        }
+        case Opcode::MEMCPY: {
+            int length = bulkLength();
+            std::string dst = std::to_string(bulkStart(length));
+            std::string src = std::to_string(bulkStart(length));
+            return std::make_shared<MemcpyInstruction>(dst, src, std::to_string(length));
+        }
+        default:
+            return nullptr;
+        }
+    };
+
+    for (int i = 0; i < count; ++i) {
+        Opcode op = pickOpcode(true);
+        if (op == Opcode::FOR) {
+            std::string body;
+            int bodyLen = static_cast<int>(rng.range(for_body_min, for_body_max));
+            for (int b = 0; b < bodyLen; ++b) {
+                if (b > 0) body += "; ";
+                body += makeInstruction(pickOpcode(false))->toString();
+            }
+            int repeats = static_cast<int>(rng.range(for_repeats_min, for_repeats_max));
+            ins.push_back(std::make_shared<ForInstruction>(body, repeats));
+            continue;
+        }
+        ins.push_back(makeInstruction(op));
+    }
+}
+
+// Reads "<key> <min> <max>" style ranges; a single value means min == max
+static bool readRange(std::istringstream& in, int& lo, int& hi) {
+    if (!(in >> lo)) return false;
+    if (!(in >> hi)) hi = lo;
+    if (hi < lo) std::swap(lo, hi);
+    return lo >= 0;
+}
+
+bool loadWorkloadFile(const std::string& filename, std::unordered_map<std::string, WorkloadProfile>& out) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        consoleOut() << "Error: workload file " << filename << " not found.\n";
+        return false;
+    }
+
+    WorkloadProfile current;
+    bool inProfile = false;
+    std::string line;
+    int lineNo = 0;
+
+    auto fail = [&](const std::string& why) {
+        consoleOut() << "Error: " << filename << ":" << lineNo << ": " << why << "\n";
+        return false;
+    };
+
+    while (std::getline(file, line)) {
+        lineNo++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) continue;
+
+        if (key == "profile") {
+            if (inProfile) return fail("missing 'end' before new profile");
+            current = WorkloadProfile();
+            if (!(in >> current.name)) return fail("profile needs a name");
+            inProfile = true;
+            continue;
+        }
+        if (!inProfile) return fail("'" + key + "' outside of a profile block");
+
+        if (key == "end") {
+            out[current.name] = current;
+            inProfile = false;
+        }
+        else if (key == "weight") {
+            std::string op;
+            int weight = 0;
+            if (!(in >> op >> weight) || weight < 0) return fail("usage: weight <OPCODE> <n>");
+            std::transform(op.begin(), op.end(), op.begin(),
+                [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
+            auto it = std::find_if(std::begin(OPCODE_NAMES), std::end(OPCODE_NAMES),
+                [&](const char* name) { return name && op == name; });
+            if (it == std::end(OPCODE_NAMES)) return fail("unknown opcode " + op);
+            current.weights[it - std::begin(OPCODE_NAMES)] = weight;
+        }
+        else if (key == "for-repeats") {
+            if (!readRange(in, current.for_repeats_min, current.for_repeats_max)) return fail("usage: for-repeats <min> [max]");
+        }
+        else if (key == "for-body") {
+            if (!readRange(in, current.for_body_min, current.for_body_max) || current.for_body_min == 0)
+                return fail("usage: for-body <min> [max] (at least 1)");
+        }
+        else if (key == "bulk-length") {
+            if (!readRange(in, current.bulk_min, current.bulk_max)) return fail("usage: bulk-length <min> [max]");
+        }
+        else if (key == "sleep") {
+            if (!readRange(in, current.sleep_min, current.sleep_max)) return fail("usage: sleep <min> [max]");
+        }
+        else if (key == "variables") {
+            if (!(in >> current.variables) || current.variables < 1 || current.variables > 32)
+                return fail("variables must be between 1 and 32");
+        }
+        else if (key == "value-max") {
+            if (!(in >> current.value_max) || current.value_max < 0) return fail("usage: value-max <n>");
+        }
+        else if (key == "addresses") {
+            std::string pattern;
+            in >> pattern;
+            if (pattern == "uniform") current.addresses = AddressPattern::UNIFORM;
+            else if (pattern == "sequential") current.addresses = AddressPattern::SEQUENTIAL;
+            else if (pattern == "strided") {
+                current.addresses = AddressPattern::STRIDED;
+                if (!(in >> current.stride) || current.stride <= 0) return fail("usage: addresses strided <bytes>");
+            }
+            else if (pattern == "zipf") {
+                current.addresses = AddressPattern::ZIPF;
+                if (!(in >> current.zipf_exponent)) current.zipf_exponent = 1.0;
+                if (current.zipf_exponent <= 0) return fail("zipf exponent must be positive");
+            }
+            else return fail("unknown address pattern '" + pattern + "'");
+        }
+        else return fail("unknown key '" + key + "'");
+    }
+
+    if (inProfile) return fail("profile '" + current.name + "' is missing 'end'");
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "Random.h"
+#include "Instruction.h"
+
+// === Workload profiles ===
+// A profile describes the instruction mix of generated processes. Profiles are
+// loaded from the file named by "workload-file" and chosen with "workload-profile";
+// the built-in "default" profile keeps the original 11-instruction pool.
+enum class AddressPattern { UNIFORM, SEQUENTIAL, STRIDED, ZIPF };
+
+struct WorkloadProfile {
+    std::string name;
+    int weights[static_cast<int>(Opcode::COUNT)] = { 1, 1, 1, 1, 1, 1, 1, 1 }; // NOP, MEMSET, MEMCPY stay 0
+    int for_repeats_min = 1, for_repeats_max = 3;
+    int for_body_min = 1, for_body_max = 3;
+    int sleep_min = 1, sleep_max = 3;
+    int bulk_min = 16, bulk_max = 256;  // MEMSET/MEMCPY length in bytes
+    int variables = 5;                 // distinct variable names used (max 32)
+    int value_max = 100;               // DECLARE literals are drawn from [0, value_max]
+
+    AddressPattern addresses = AddressPattern::UNIFORM;
+    int stride = 2;                    // bytes between accesses for "strided"
+    double zipf_exponent = 1.0;        // skew for "zipf"; pages are ranked hottest-first
+
+    // Appends count generated instructions to out
+    void generate(InstructionList& out, int count, int memSize, Rng& rng) const;
+};
+
+// Loads every "profile <name> ... end" block in the file; returns false on a malformed file
+bool loadWorkloadFile(const std::string& filename, std::unordered_map<std::string, WorkloadProfile>& out);
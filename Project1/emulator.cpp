@@ -1,5 +1,16 @@
 #include "globals.h"
+#include "Emulator.h"
 #include "Instruction.h"
+#include "Random.h"
+#include "ProcessGenerator.h"
+#include "Workload.h"
+#include "ProgramLoader.h"
+#include "ThreadPool.h"
+#include "ControlServer.h"
+#include "Metrics.h"
+#include "PerfStats.h"
+#include "Snapshot.h"
+#include "Optimizer.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -14,25 +25,66 @@
 #include <deque>
 #include <algorithm>
 #include <cctype>
+#include <random>
+#include <filesystem>
+#include <optional>
+#include <type_traits>
 
 // === Global variables ===
-std::mutex io_mutex;
-std::mutex processTableMutex;
-bool initialized = false;
-Config systemConfig;
-ConsoleMode mode = ConsoleMode::MAIN;
-std::deque<Process> processTable;
-std::vector<CPUCore> cpuCores;
-int nextPID = 1;
-std::string current_process = "";
-std::atomic<bool> autoCreateRunning{ false };
-std::atomic<bool> schedulerRunning{ false };
-std::thread schedulerThread;
-unsigned long long global_tick = 0;
-size_t rrCursor = 0;
-
-// === Forward declarations ===
-void scheduler_loop_tick(bool hasActiveWork);
+InstrumentedMutex io_mutex("io_mutex");
+InstrumentedMutex commandMutex("commandMutex");
+
+// === Console output ===
+namespace {
+    thread_local std::ostream* consoleSink = nullptr; // nullptr = std::cout
+}
+
+std::ostream& consoleOut() {
+    return consoleSink ? *consoleSink : std::cout;
+}
+
+ConsoleOutput::ConsoleOutput(std::ostream& to) : previous(consoleSink) {
+    consoleSink = &to;
+}
+
+ConsoleOutput::~ConsoleOutput() {
+    consoleSink = previous;
+}
+
+// === Emulator instance ===
+namespace {
+    thread_local Emulator* boundEmulator = nullptr;
+}
+
+Emulator::Emulator() : recorder(*this), processGenerator(*this) {}
+
+Emulator::~Emulator() {
+    shutdown();
+}
+
+void Emulator::shutdown() {
+    schedulerRunning.store(false);
+    if (schedulerThread.joinable()) schedulerThread.join();
+    processGenerator.stop();
+    recorder.stop();
+}
+
+Emulator& consoleEmulator() {
+    static Emulator instance;
+    return instance;
+}
+
+Emulator& emu() {
+    return boundEmulator ? *boundEmulator : consoleEmulator();
+}
+
+EmulatorBinding::EmulatorBinding(Emulator& instance) : previous(boundEmulator) {
+    boundEmulator = &instance;
+}
+
+EmulatorBinding::~EmulatorBinding() {
+    boundEmulator = previous;
+}
 
 // === Utility functions ===
 static std::string trim(const std::string& str) {
@@ -70,7 +122,7 @@ std::vector<std::string> tokenize(const std::string& input) {
 bool generateDefaultConfig(const std::string& filename) {
     std::ofstream file(filename);
     if (!file.is_open()) {
-        std::cout << "Error: Could not create " << filename << std::endl;
+        consoleOut() << "Error: Could not create " << filename << std::endl;
         return false;
     }
 
@@ -85,18 +137,63 @@ bool generateDefaultConfig(const std::string& filename) {
     file << "mem-per-frame 16\n";
     file << "min-mem-per-proc 4096\n";
     file << "max-mem-per-proc 4096\n";
+    file << "seed 0\n";
     file.close();
 
-    std::cout << "Default config.txt generated with safe defaults.\n";
+    consoleOut() << "Default config.txt generated with safe defaults.\n";
     return true;
 }
 
-bool loadConfigFile(const std::string& filename) {
-    std::ifstream file(filename);
+// Applies one "key value" setting; false for a key it does not know. Numbers go
+// through std::stoi and friends, which throw on text that is not one.
+static bool applyConfigSetting(Config& config, const std::string& key, const std::string& value) {
+    if (key == "num-cpu") config.num_cpu = std::stoi(value);
+    else if (key == "scheduler") {
+        config.scheduler = value;
+        std::transform(config.scheduler.begin(), config.scheduler.end(),
+            config.scheduler.begin(),
+            [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    }
+    else if (key == "quantum-cycles") config.quantum_cycles = std::stoi(value);
+    else if (key == "batch-process-freq") config.batch_process_freq = std::stoi(value);
+    else if (key == "min-ins") config.min_ins = std::stoi(value);
+    else if (key == "max-ins") config.max_ins = std::stoi(value);
+    else if (key == "delays-per-exec") config.delays_per_exec = std::stoi(value);
+    else if (key == "exec-mode") config.exec_mode = value;
+    else if (key == "optimize") config.optimize = value;
+    else if (key == "max-overall-mem") config.max_overall_mem = std::stoul(value);
+    else if (key == "mem-per-frame") config.mem_per_frame = std::stoul(value);
+    else if (key == "min-mem-per-proc") config.min_mem_per_proc = std::stoul(value);
+    else if (key == "max-mem-per-proc") config.max_mem_per_proc = std::stoul(value);
+    else if (key == "bulk-page-ticks") config.bulk_page_ticks = std::stoi(value);
+    else if (key == "metrics-interval") config.metrics_interval = std::stoull(value);
+    else if (key == "metrics-csv") config.metrics_csv = value;
+    else if (key == "metrics-prom") config.metrics_prom = value;
+    else if (key == "workload-file") config.workload_file = value;
+    else if (key == "workload-profile") config.workload_profile = value;
+    else if (key == "program-cache") config.program_cache = value;
+    else if (key == "seed") {
+        config.seed = std::stoull(value);
+        config.has_seed = config.seed != 0; // 0 = pick a fresh seed per run
+    }
+    else return false;
+    return true;
+}
 
-    if (!file.is_open()) {
-        std::cout << "Warning: " << filename << " not found.\n";
-        std::cout << "Creating default configuration file...\n";
+// An empty filename uses only the overrides (e.g. a config restored from a recording).
+// Only a plain load may rewrite the file: with overrides (a sweep run, possibly one of
+// several at once) a missing or invalid config is an error instead.
+bool loadConfigFile(const std::string& filename, const ConfigOverrides& overrides) {
+    std::ifstream file;
+    if (!filename.empty()) file.open(filename);
+
+    if (!filename.empty() && !file.is_open()) {
+        if (!overrides.empty()) {
+            consoleOut() << "Error: " << filename << " not found.\n";
+            return false;
+        }
+        consoleOut() << "Warning: " << filename << " not found.\n";
+        consoleOut() << "Creating default configuration file...\n";
 
         if (!generateDefaultConfig(filename)) return false;
 
@@ -104,70 +201,154 @@ bool loadConfigFile(const std::string& filename) {
         if (!file.is_open()) return false;
     }
 
-    std::string key, value;
-    while (file >> key >> value) {
-        if (key == "num-cpu") systemConfig.num_cpu = std::stoi(value);
-        else if (key == "scheduler") {
-            systemConfig.scheduler = value;
-            std::transform(systemConfig.scheduler.begin(), systemConfig.scheduler.end(),
-                systemConfig.scheduler.begin(),
-                [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    // Overrides come after the file's own settings so they win
+    ConfigOverrides settings;
+    std::string fileKey, fileValue;
+    while (file.is_open() && file >> fileKey >> fileValue) settings.emplace_back(fileKey, fileValue);
+    file.close();
+    const size_t fileSettings = settings.size();
+    settings.insert(settings.end(), overrides.begin(), overrides.end());
+
+    for (size_t i = 0; i < settings.size(); ++i) {
+        const auto& [key, value] = settings[i];
+        try {
+            if (!applyConfigSetting(emu().systemConfig, key, value) && i >= fileSettings) {
+                // The file may carry keys of other versions; an override naming one is a typo
+                consoleOut() << "Error: Unknown config key '" << key << "'.\n";
+                return false;
+            }
+        }
+        catch (const std::logic_error&) { // std::stoi and friends: not a number, or out of range
+            consoleOut() << "Error: Invalid value '" << value << "' for " << key << ".\n";
+            return false;
         }
-        else if (key == "quantum-cycles") systemConfig.quantum_cycles = std::stoi(value);
-        else if (key == "batch-process-freq") systemConfig.batch_process_freq = std::stoi(value);
-        else if (key == "min-ins") systemConfig.min_ins = std::stoi(value);
-        else if (key == "max-ins") systemConfig.max_ins = std::stoi(value);
-        else if (key == "delays-per-exec") systemConfig.delays_per_exec = std::stoi(value);
-        else if (key == "max-overall-mem") systemConfig.max_overall_mem = std::stoul(value);
-        else if (key == "mem-per-frame") systemConfig.mem_per_frame = std::stoul(value);
-        else if (key == "min-mem-per-proc") systemConfig.min_mem_per_proc = std::stoul(value);
-        else if (key == "max-mem-per-proc") systemConfig.max_mem_per_proc = std::stoul(value);
     }
 
-    file.close();
-
-    if (systemConfig.scheduler != "rr" && systemConfig.scheduler != "fcfs") {
-        std::cout << "Warning: Unsupported scheduler '" << systemConfig.scheduler
+    if (emu().systemConfig.scheduler != "rr" && emu().systemConfig.scheduler != "fcfs") {
+        consoleOut() << "Warning: Unsupported scheduler '" << emu().systemConfig.scheduler
             << "'. Defaulting to round-robin.\n";
-        systemConfig.scheduler = "rr";
+        emu().systemConfig.scheduler = "rr";
+    }
+
+    if (emu().systemConfig.exec_mode != "tick" && emu().systemConfig.exec_mode != "quantum") {
+        consoleOut() << "Warning: Unsupported exec-mode '" << emu().systemConfig.exec_mode
+            << "'. Defaulting to tick.\n";
+        emu().systemConfig.exec_mode = "tick";
+    }
+
+    OptimizeMode optimizeMode;
+    if (!parseOptimizeMode(emu().systemConfig.optimize, optimizeMode)) {
+        consoleOut() << "Warning: Unsupported optimize '" << emu().systemConfig.optimize
+            << "'. Defaulting to off.\n";
+        emu().systemConfig.optimize = "off";
+    }
+
+    if (emu().systemConfig.bulk_page_ticks < 0) {
+        consoleOut() << "Warning: bulk-page-ticks must be >= 0. Defaulting to 1.\n";
+        emu().systemConfig.bulk_page_ticks = 1;
     }
 
     // Validate basic config
-    if (systemConfig.num_cpu <= 0 || systemConfig.scheduler.empty()) {
-        std::cout << "Invalid config. Regenerating defaults.\n";
+    if (emu().systemConfig.num_cpu <= 0 || emu().systemConfig.scheduler.empty()) {
+        if (filename.empty() || !overrides.empty()) {
+            consoleOut() << "Error: Invalid config.\n";
+            return false;
+        }
+        consoleOut() << "Invalid config. Regenerating defaults.\n";
         generateDefaultConfig(filename);
-        return loadConfigFile(filename);
+        return loadConfigFile(filename, overrides);
     }
 
     // Initialize CPU cores based on config
-    cpuCores.clear();
-    cpuCores.resize(systemConfig.num_cpu);
-    for (int i = 0; i < systemConfig.num_cpu; ++i) {
-        cpuCores[i].id = i;
-        cpuCores[i].running = nullptr;
-        cpuCores[i].quantum_left = 0;
+    emu().cpuCores.clear();
+    emu().cpuCores.resize(emu().systemConfig.num_cpu);
+    for (int i = 0; i < emu().systemConfig.num_cpu; ++i) {
+        emu().cpuCores[i].id = i;
+        emu().cpuCores[i].running = ProcessHandle{};
+        emu().cpuCores[i].quantum_left = 0;
     }
 
-    systemConfig.loaded = true;
-    std::cout << "Loaded " << systemConfig.num_cpu << " CPU cores.\n";
-    std::cout << "Memory: " << systemConfig.max_overall_mem << " bytes (" 
-              << systemConfig.mem_per_frame << " bytes/frame)\n";
+    emu().systemConfig.loaded = true;
+    consoleOut() << "Loaded " << emu().systemConfig.num_cpu << " CPU cores.\n";
+    consoleOut() << "Memory: " << emu().systemConfig.max_overall_mem << " bytes (" 
+              << emu().systemConfig.mem_per_frame << " bytes/frame)\n";
 
     return true;
 }
 
 
+ConfigOverrides configToSettings(const Config& config) {
+    ConfigOverrides settings = {
+        { "num-cpu", std::to_string(config.num_cpu) },
+        { "scheduler", config.scheduler },
+        { "quantum-cycles", std::to_string(config.quantum_cycles) },
+        { "batch-process-freq", std::to_string(config.batch_process_freq) },
+        { "min-ins", std::to_string(config.min_ins) },
+        { "max-ins", std::to_string(config.max_ins) },
+        { "delays-per-exec", std::to_string(config.delays_per_exec) },
+        { "exec-mode", config.exec_mode },
+        { "optimize", config.optimize },
+        { "max-overall-mem", std::to_string(config.max_overall_mem) },
+        { "mem-per-frame", std::to_string(config.mem_per_frame) },
+        { "min-mem-per-proc", std::to_string(config.min_mem_per_proc) },
+        { "max-mem-per-proc", std::to_string(config.max_mem_per_proc) },
+        { "bulk-page-ticks", std::to_string(config.bulk_page_ticks) },
+        { "metrics-interval", std::to_string(config.metrics_interval) },
+        { "workload-profile", config.workload_profile },
+        { "seed", std::to_string(config.seed) },
+    };
+    // Paths are single tokens in the config format, so unset ones are left out
+    if (!config.metrics_csv.empty()) settings.emplace_back("metrics-csv", config.metrics_csv);
+    if (!config.metrics_prom.empty()) settings.emplace_back("metrics-prom", config.metrics_prom);
+    if (!config.workload_file.empty()) settings.emplace_back("workload-file", config.workload_file);
+    if (!config.program_cache.empty()) settings.emplace_back("program-cache", config.program_cache);
+    return settings;
+}
+
+
 // === Process helpers ===
-Process* findProcess(const std::string& name) {
-    for (auto& p : processTable)
-        if (p.name == name)
-            return &p;
+ProcessHandle findProcess(const std::string& name) {
+    ProcessTable& table = emu().processTable;
+    for (size_t slot = 0; slot < table.slotCount(); ++slot) {
+        ProcessHandle h = table.handleAt(slot);
+        if (h && table[slot].name == name) return h;
+    }
+    return ProcessHandle{};
+}
+
+const FinishedProcess* findFinishedProcess(const std::string& name) {
+    for (const FinishedProcess& p : emu().finishedProcesses) {
+        if (p.name == name) return &p;
+    }
     return nullptr;
 }
 
+// Names stay taken after the process ends, so screen -r and process-smi keep resolving them
+bool processNameTaken(const std::string& name) {
+    return findProcess(name) || findFinishedProcess(name);
+}
+
+// Hands an ended process's memory back and moves its record to finishedProcesses
+void retireProcess(ProcessHandle h) {
+    emu().memoryManager->retireProcess(h, emu().finishedProcesses);
+}
+
+// Runs the configured optimizer over a new process's program and interns the result
+ProgramRef prepareProgram(InstructionList ins) {
+    OptimizeMode mode = OptimizeMode::OFF;
+    parseOptimizeMode(emu().systemConfig.optimize, mode);
+    optimizeProgram(ins, 0, SymbolTable{}, mode);
+    return ProgramImage::intern(std::move(ins));
+}
+
 // Generate dummy instructions for a process 
-std::vector<std::shared_ptr<Instruction>> generateDummyInstructions(int count, int memSize) {
-    std::vector<std::shared_ptr<Instruction>> ins;
+void generateDummyInstructions(InstructionList& ins, int count, int memSize, Rng& rng) {
+    if (emu().activeWorkload) {
+        emu().activeWorkload->generate(ins, count, memSize, rng);
+        return;
+    }
+
+    ins.reserve(ins.size() + count);
     static std::vector<std::string> pool = {
         "DECLARE(x, 5)",
         "DECLARE(y, 10)",
@@ -182,86 +363,120 @@ std::vector<std::shared_ptr<Instruction>> generateDummyInstructions(int count, i
         "PRINT('Loaded value: ' + val)"
     };
     for (int i = 0; i < count; ++i) {
-        std::string line = pool[rand() % pool.size()];
+        std::string line = pool[rng.below(pool.size())];
         
         // Replace %ADDR% with random address
         size_t pos = line.find("%ADDR%");
         if (pos != std::string::npos) {
-            int randomAddr = rand() % memSize;
+            int randomAddr = static_cast<int>(rng.below(memSize));
             line.replace(pos, 6, std::to_string(randomAddr));
         }
 
         auto inst = parseInstruction(line);
-        if (inst) ins.push_back(inst);
+        if (inst) ins.push_back(std::move(inst));
     }
-    return ins;
 }
 
 // Trace function
-void logInstructionTrace(Process& p, const std::shared_ptr<Instruction>& instr) {
-    std::ofstream trace("csopesy-trace.txt", std::ios::app);
-    if (!trace.is_open()) return;
-
-    // Real timestamp
-    auto now = std::chrono::system_clock::now();
-    std::time_t now_time = std::chrono::system_clock::to_time_t(now);
-    std::tm tm_buf{};
+void logInstructionTrace(Process& p, const Instruction& instr, unsigned long long tick) {
+    Emulator& sim = emu();
+    if (!sim.traceEnabled) return;
+    PERF_SCOPE(traceScope, PerfPoint::TRACE_WRITE);
+
+    if (!sim.traceFile.is_open()) {
+        sim.traceFile.open(sim.tracePath, std::ios::app);
+        if (!sim.traceFile.is_open()) return;
+    }
+
+    // Real timestamp, reformatted only when the second changes
+    thread_local std::time_t stampTime = 0;
+    thread_local char stamp[32] = {};
+    std::time_t now_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    if (now_time != stampTime) {
+        std::tm tm_buf{};
 #ifdef _WIN32
-    localtime_s(&tm_buf, &now_time);
+        localtime_s(&tm_buf, &now_time);
 #else
-    localtime_r(&now_time, &tm_buf);
+        localtime_r(&now_time, &tm_buf);
 #endif
-
-    std::ostringstream timestamp;
-    timestamp << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+        stampTime = now_time;
+    }
 
     // Process state as string
-    std::string stateStr;
-    switch (p.state) {
+    const char* stateStr = "";
+    switch (p.state()) {
     case ProcessState::READY: stateStr = "READY"; break;
     case ProcessState::RUNNING: stateStr = "RUNNING"; break;
     case ProcessState::SLEEPING: stateStr = "SLEEPING"; break;
     case ProcessState::FINISHED: stateStr = "FINISHED"; break;
+    default: break;
     }
 
-    // Combined log entry
-    trace << "[" << timestamp.str() << "] ";
+    // Combined log entry, built without allocating
+    auto build = [&](TextBuffer& line) {
+        line.append('[');
+        line.append(stamp);
+        line.append("] [Tick ");
+        line.appendInt(tick);
+        if (sim.systemConfig.scheduler == "rr" && sim.systemConfig.quantum_cycles > 0) {
+            line.append(" | Q");
+            line.appendInt((p.pc % sim.systemConfig.quantum_cycles) + 1);
+            line.append('/');
+            line.appendInt(sim.systemConfig.quantum_cycles);
+        }
+        else if (sim.systemConfig.scheduler == "fcfs") {
+            line.append(" | FCFS");
+        }
+        line.append("] ");
+        line.append(p.name);
+        line.append(" [PID ");
+        line.appendInt(p.pid);
+        line.append("] pc=");
+        line.appendInt(p.pc);
+        line.append('/');
+        line.appendInt(p.program->size());
+        line.append(" -> ");
+        instr.format(line);
+        line.append(" | State=");
+        line.append(stateStr);
+        line.append('\n');
+    };
 
-    trace << "[Tick " << global_tick;
-    if (systemConfig.scheduler == "rr" && systemConfig.quantum_cycles > 0) {
-        int quantumPos = (p.pc % systemConfig.quantum_cycles) + 1;
-        trace << " | Q" << quantumPos << "/" << systemConfig.quantum_cycles;
+    char text[512];
+    TextBuffer line(text, sizeof(text));
+    build(line);
+    if (!line.overflowed()) {
+        sim.traceFile.write(line.view().data(), static_cast<std::streamsize>(line.required()));
     }
-    else if (systemConfig.scheduler == "fcfs") {
-        trace << " | FCFS";
+    else {
+        // Long PRINT/FOR bodies only
+        std::string full(line.required(), '\0');
+        TextBuffer retry(full.data(), full.size());
+        build(retry);
+        sim.traceFile << full;
     }
-    trace << "] "
-        << p.name << " [PID " << p.pid << "] pc="
-        << p.pc << "/" << p.instructions.size()
-        << " -> " << instr->toString()
-        << " | State=" << stateStr << "\n";
-    trace.close();
+    sim.traceFile.flush();
 }
 
 // Ensure the scheduler thread is running
 void ensureSchedulerActive() {
-    if (!schedulerRunning.load() && initialized) {
-        schedulerRunning.store(true);
-        schedulerThread = std::thread([]() {
-            while (schedulerRunning.load()) {
+    Emulator& instance = emu();
+    if (instance.externalTicks) return;
+    if (!instance.schedulerRunning.load() && instance.initialized) {
+        if (instance.schedulerThread.joinable()) instance.schedulerThread.join(); // previous run has halted
+        instance.schedulerRunning.store(true);
+        instance.schedulerThread = std::thread([&instance]() {
+            EmulatorBinding bind(instance);
+            while (emu().schedulerRunning.load()) {
 
                 bool shouldTick = false;
                 {
-                    std::lock_guard<std::mutex> lock(processTableMutex);
-                    shouldTick = std::any_of(processTable.begin(), processTable.end(),
-                        [](const Process& p) {
-                            return p.state == ProcessState::READY ||
-                                p.state == ProcessState::RUNNING ||
-                                p.state == ProcessState::SLEEPING;
-                        });
+                    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+                    shouldTick = emu().processTable.anyActive();
                 }
 
-                bool tickNow = shouldTick || autoCreateRunning.load();
+                bool tickNow = shouldTick || emu().autoCreateRunning.load();
                 if (tickNow) {
                     scheduler_loop_tick(tickNow);
                 }
@@ -271,73 +486,154 @@ void ensureSchedulerActive() {
 
                 bool shouldStop = false;
                 {
-                    std::lock_guard<std::mutex> lock(processTableMutex);
-                    bool allFinished = !processTable.empty() &&
-                        std::all_of(processTable.begin(), processTable.end(),
-                            [](const Process& p) { return p.state == ProcessState::FINISHED; });
+                    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+                    bool allFinished = !emu().processTable.anyActive(); // ended processes are retired
 
-                    if (allFinished && !autoCreateRunning.load()) {
-                        schedulerRunning.store(false);
+                    if (allFinished && !emu().autoCreateRunning.load()) {
+                        emu().schedulerRunning.store(false);
                         shouldStop = true;
                     }
                 }
 
                 if (shouldStop) {
-                    std::cout << "[Tick " << global_tick
+                    consoleOut() << "[Tick " << emu().global_tick
                         << "] Scheduler halted (all processes finished).\n";
                     break;
                 }
             }
             });
-        schedulerThread.detach();
-        std::cout << "Scheduler thread started.\n";
+        consoleOut() << "Scheduler thread started.\n";
     }
 }
 
 // === COMMANDS ===
+// Loads the config file and sets up the memory manager (shared by the console and headless mode)
+bool initializeSystem(const std::string& configFile, const ConfigOverrides& overrides) {
+    if (!loadConfigFile(configFile, overrides)) return false;
+
+    // Workload profile for generated processes ("default" = built-in instruction pool)
+    emu().activeWorkload = nullptr;
+    if (!emu().systemConfig.workload_file.empty()) {
+        emu().workloadProfiles.clear();
+        if (!loadWorkloadFile(emu().systemConfig.workload_file, emu().workloadProfiles)) return false;
+    }
+    if (emu().systemConfig.workload_profile != "default") {
+        auto it = emu().workloadProfiles.find(emu().systemConfig.workload_profile);
+        if (it == emu().workloadProfiles.end()) {
+            consoleOut() << "Warning: Unknown workload profile '" << emu().systemConfig.workload_profile
+                << "'. Using the default instruction pool.\n";
+            emu().systemConfig.workload_profile = "default";
+        }
+        else {
+            emu().activeWorkload = &it->second;
+        }
+    }
+
+    emu().metricsExporter.configure(emu().systemConfig.metrics_interval, emu().systemConfig.metrics_csv, emu().systemConfig.metrics_prom);
+
+    if (!emu().systemConfig.has_seed) {
+        std::random_device rd;
+        emu().systemConfig.seed = (static_cast<unsigned long long>(rd()) << 32) | rd();
+        emu().systemConfig.has_seed = true;
+    }
+
+    size_t total_frames = emu().systemConfig.max_overall_mem / emu().systemConfig.mem_per_frame;
+    emu().memoryManager = std::make_unique<MemoryManager>(total_frames, emu().systemConfig.mem_per_frame, emu().backingStorePath);
+    emu().initialized = true;
+    return true;
+}
+
 // initialize command
 void initializeCommand() {
-    if (systemConfig.loaded) {
-        std::cout << "System already initialized.\n";
+    if (emu().systemConfig.loaded) {
+        consoleOut() << "System already initialized.\n";
         return;
     }
 
-    std::cout << "Initializing system from config.txt...\n";
+    consoleOut() << "Initializing system from config.txt...\n";
 
-    if (!loadConfigFile("config.txt")) {
-        std::cout << "Initialization failed. Please check config.txt.\n";
+    if (!initializeSystem("config.txt")) {
+        consoleOut() << "Initialization failed. Please check config.txt.\n";
         return;
     }
 
-    initialized = true;
-    std::cout << "Configuration loaded successfully:\n";
-    std::cout << "  num-cpu: " << systemConfig.num_cpu << "\n";
-    std::cout << "  scheduler: " << systemConfig.scheduler << "\n";
-    std::cout << "  quantum-cycles: " << systemConfig.quantum_cycles << "\n";
-    std::cout << "  batch-process-freq: " << systemConfig.batch_process_freq << "\n";
-    std::cout << "  instruction range: " << systemConfig.min_ins << "-" << systemConfig.max_ins << "\n";
-    std::cout << "  delays-per-exec: " << systemConfig.delays_per_exec << "\n";
-    
-    // Initialize Memory Manager
-    size_t total_frames = systemConfig.max_overall_mem / systemConfig.mem_per_frame;
-    memoryManager = std::make_unique<MemoryManager>(total_frames, systemConfig.mem_per_frame);
-    
-    std::cout << "  Memory Initialized: " << total_frames << " frames x " 
-              << systemConfig.mem_per_frame << " bytes\n";
+    consoleOut() << "Configuration loaded successfully:\n";
+    consoleOut() << "  num-cpu: " << emu().systemConfig.num_cpu << "\n";
+    consoleOut() << "  scheduler: " << emu().systemConfig.scheduler << "\n";
+    consoleOut() << "  quantum-cycles: " << emu().systemConfig.quantum_cycles << "\n";
+    consoleOut() << "  exec-mode: " << emu().systemConfig.exec_mode << "\n";
+    consoleOut() << "  optimize: " << emu().systemConfig.optimize << "\n";
+    consoleOut() << "  batch-process-freq: " << emu().systemConfig.batch_process_freq << "\n";
+    consoleOut() << "  instruction range: " << emu().systemConfig.min_ins << "-" << emu().systemConfig.max_ins << "\n";
+    consoleOut() << "  delays-per-exec: " << emu().systemConfig.delays_per_exec << "\n";
+    consoleOut() << "  workload-profile: " << emu().systemConfig.workload_profile << "\n";
+    if (!emu().systemConfig.program_cache.empty()) {
+        consoleOut() << "  program-cache: " << emu().systemConfig.program_cache << "\n";
+    }
+    consoleOut() << "  seed: " << emu().systemConfig.seed << "\n";
+    consoleOut() << "  Memory Initialized: " << emu().memoryManager->getTotalFrames() << " frames x " 
+              << emu().systemConfig.mem_per_frame << " bytes\n";
+    consoleOut() << "  bulk-page-ticks: " << emu().systemConfig.bulk_page_ticks << "\n";
+
+    consoleOut() << "System initialization complete.\n\n";
+}
+
+
+// Parses a memory argument and checks the power-of-2 rule and the configured range
+static bool parseProcessMemory(const std::string& arg, int& memory) {
+    try {
+        memory = std::stoi(arg);
+    }
+    catch (...) {
+        consoleOut() << "Error: Invalid memory argument. Must be an integer.\n";
+        return false;
+    }
 
-    std::cout << "System initialization complete.\n\n";
+    // Validate power of 2
+    if (memory <= 0 || (memory & (memory - 1)) != 0) {
+        consoleOut() << "Error: Memory must be a power of 2.\n";
+        return false;
+    }
+
+    // Validate range
+    if (memory < emu().systemConfig.min_mem_per_proc || memory > emu().systemConfig.max_mem_per_proc) {
+        consoleOut() << "invalid memory allocation\n";
+        return false;
+    }
+    return true;
 }
 
+// Adds a READY process running the given program; returns its pid, or -1 if the name is taken
+int createProcess(const std::string& name, int memory, std::vector<std::shared_ptr<Instruction>> instructions) {
+    Process newProc(emu().processTable.resource());
+    newProc.name = name;
+    newProc.setState(ProcessState::READY);
+    newProc.program = prepareProgram(std::move(instructions));
+    newProc.memory_required = memory;
+
+    // Memory Allocation
+    int pages = (memory + emu().systemConfig.mem_per_frame - 1) / emu().systemConfig.mem_per_frame;
+    emu().memoryManager->initializePageTable(newProc, pages);
+
+    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+    if (processNameTaken(name)) return -1;
+    newProc.pid = emu().nextPID++;
+    newProc.arrival_tick = emu().global_tick;
+    ProcessHandle h = emu().processTable.insert(std::move(newProc));
+    return emu().processTable.get(h)->pid;
+}
 
 // screen
-void handleScreenCommand(const std::vector<std::string>& args) {
-    if (!initialized) {
-        std::cout << "Error: System not initialized. Type 'initialize' first.\n";
+void handleScreenCommand(Session& session, const std::vector<std::string>& args) {
+    if (!emu().initialized) {
+        consoleOut() << "Error: System not initialized. Type 'initialize' first.\n";
         return;
     }
     if (args.size() == 1) {
-        std::cout << "Usage:\n"
+        consoleOut() << "Usage:\n"
             << "  screen -s <process_name> <memory>\n"
+            << "  screen -c <process_name> <memory> \"<instructions>\"\n"
+            << "  screen -f <process_name> <memory> <program_file>\n"
             << "  screen -r <process_name>\n"
             << "  screen -ls\n";
         return;
@@ -347,88 +643,70 @@ void handleScreenCommand(const std::vector<std::string>& args) {
     // --- Create new process ---
     if (flag == "-s") {
         if (args.size() != 4) {
-            std::cout << "Usage: screen -s <process_name> <memory>\n";
+            consoleOut() << "Usage: screen -s <process_name> <memory>\n";
             return;
         }
 
         std::string name = args[2];
         int memory = 0;
-        try {
-            memory = std::stoi(args[3]);
-        }
-        catch (...) {
-            std::cout << "Error: Invalid memory argument. Must be an integer.\n";
-            return;
-        }
+        if (!parseProcessMemory(args[3], memory)) return;
 
-        // Validate power of 2
-        if (memory <= 0 || (memory & (memory - 1)) != 0) {
-            std::cout << "Error: Memory must be a power of 2.\n";
-            return;
-        }
-
-        // Validate range
-        if (memory < systemConfig.min_mem_per_proc || memory > systemConfig.max_mem_per_proc) {
-            std::cout << "invalid memory allocation\n";
-            return;
+        // The workload stream is keyed by pid, so the process is built for the next free pid
+        // and claims it only when it goes into the table; if a concurrent creation took that
+        // pid meanwhile, it is built again for the next one
+        int pid = 0;
+        {
+            std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+            pid = emu().nextPID;
         }
+        while (true) {
+            Process newProc(emu().processTable.resource());
+            newProc.pid = pid;
+            newProc.name = name;
+            newProc.setState(ProcessState::READY);
+            Rng rng = Rng::forProcess(emu().systemConfig.seed, newProc.pid);
+            int insCount = static_cast<int>(rng.range(emu().systemConfig.min_ins, emu().systemConfig.max_ins));
+            InstructionList ins;
+            generateDummyInstructions(ins, insCount, memory, rng);
+            newProc.program = prepareProgram(std::move(ins));
 
-        Process newProc;
-        newProc.name = name;
-        newProc.state = ProcessState::READY;
-        int insCount = rand() % (systemConfig.max_ins - systemConfig.min_ins + 1) + systemConfig.min_ins;
-        newProc.instructions = generateDummyInstructions(insCount, memory);
-
-        // Memory Allocation
-        newProc.memory_required = memory;
-        int pages = (memory + systemConfig.mem_per_frame - 1) / systemConfig.mem_per_frame;
-        memoryManager->initializePageTable(newProc, pages);
+            // Memory Allocation
+            newProc.memory_required = memory;
+            int pages = (memory + emu().systemConfig.mem_per_frame - 1) / emu().systemConfig.mem_per_frame;
+            emu().memoryManager->initializePageTable(newProc, pages);
 
-        {
-            std::lock_guard<std::mutex> lock(processTableMutex);
-            if (findProcess(name)) {
-                std::cout << "Process " << name << " already exists.\n";
+            std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+            if (processNameTaken(name)) {
+                consoleOut() << "Process " << name << " already exists.\n";
                 return;
             }
-            newProc.pid = nextPID++;
-            processTable.push_back(newProc);
+            if (emu().nextPID != pid) {
+                pid = emu().nextPID;
+                continue;
+            }
+            emu().nextPID++;
+            newProc.arrival_tick = emu().global_tick;
+            emu().processTable.insert(std::move(newProc));
+            break;
         }
         
-        std::cout << "Created new process: " << name << " (PID " << newProc.pid << ") with " << memory << " bytes.\n";
-        std::cout << "Attached to process screen.\n";
+        consoleOut() << "Created new process: " << name << " (PID " << pid << ") with " << memory << " bytes.\n";
+        consoleOut() << "Attached to process screen.\n";
         ensureSchedulerActive();
 
-        mode = ConsoleMode::PROCESS;
-        current_process = name;
+        session.mode = ConsoleMode::PROCESS;
+        session.current_process = name;
     }
     // --- Create new process with instructions (-c) ---
     else if (flag == "-c") {
         if (args.size() != 5) {
-            std::cout << "Usage: screen -c <process_name> <memory> \"<instructions>\"\n";
+            consoleOut() << "Usage: screen -c <process_name> <memory> \"<instructions>\"\n";
             return;
         }
 
         std::string name = args[2];
         int memory = 0;
-        try {
-            memory = std::stoi(args[3]);
-        }
-        catch (...) {
-            std::cout << "Error: Invalid memory argument. Must be an integer.\n";
-            return;
-        }
-
-        // Validate power of 2
-        if (memory <= 0 || (memory & (memory - 1)) != 0) {
-            std::cout << "Error: Memory must be a power of 2.\n";
-            return;
-        }
-
-        // Validate range
-        if (memory < systemConfig.min_mem_per_proc || memory > systemConfig.max_mem_per_proc) {
-            std::cout << "invalid memory allocation\n";
-            return;
-        }
+        if (!parseProcessMemory(args[3], memory)) return;
 
         std::string instrString = args[4];
         // Remove surrounding quotes if present
@@ -445,43 +723,61 @@ void handleScreenCommand(const std::vector<std::string>& args) {
             if (trimmed.empty()) continue;
             auto inst = parseInstruction(trimmed);
             if (!inst) {
-                std::cout << "Invalid command: " << trimmed << "\n";
+                consoleOut() << "Invalid command: " << trimmed << "\n";
                 return;
             }
             parsedInstructions.push_back(inst);
         }
 
         if (parsedInstructions.empty() || parsedInstructions.size() > 50) {
-            std::cout << "invalid command\n";
+            consoleOut() << "invalid command\n";
             return;
         }
 
-        Process newProc;
-        newProc.name = name;
-        newProc.state = ProcessState::READY;
-        newProc.instructions = parsedInstructions;
-        newProc.memory_required = memory;
+        size_t instructionCount = parsedInstructions.size();
+        int pid = createProcess(name, memory, std::move(parsedInstructions));
+        if (pid < 0) {
+            consoleOut() << "Process " << name << " already exists.\n";
+            return;
+        }
 
-        // Memory Allocation
-        int pages = (memory + systemConfig.mem_per_frame - 1) / systemConfig.mem_per_frame;
-        memoryManager->initializePageTable(newProc, pages);
+        consoleOut() << "Created new process: " << name << " (PID " << pid << ") with " << memory << " bytes and " << instructionCount << " instructions.\n";
+        consoleOut() << "Attached to process screen.\n";
+        ensureSchedulerActive();
 
-        {
-            std::lock_guard<std::mutex> lock(processTableMutex);
-            if (findProcess(name)) {
-                std::cout << "Process " << name << " already exists.\n";
-                return;
-            }
-            newProc.pid = nextPID++;
-            processTable.push_back(newProc);
+        session.mode = ConsoleMode::PROCESS;
+        session.current_process = name;
+    }
+    // --- Create new process from a program file (-f) ---
+    else if (flag == "-f") {
+        if (args.size() != 5) {
+            consoleOut() << "Usage: screen -f <process_name> <memory> <program_file>\n";
+            return;
         }
 
-        std::cout << "Created new process: " << name << " (PID " << newProc.pid << ") with " << memory << " bytes and " << parsedInstructions.size() << " instructions.\n";
-        std::cout << "Attached to process screen.\n";
+        std::string name = args[2];
+        int memory = 0;
+        if (!parseProcessMemory(args[3], memory)) return;
+
+        LoadedProgram program = std::move(loadProgramsParallel({ args[4] }, sharedThreadPool(), emu().systemConfig.program_cache).front());
+        if (!program.error.empty()) {
+            consoleOut() << "Error: " << args[4] << ": " << program.error << "\n";
+            return;
+        }
+
+        size_t instructionCount = program.instructions.size();
+        int pid = createProcess(name, memory, std::move(program.instructions));
+        if (pid < 0) {
+            consoleOut() << "Process " << name << " already exists.\n";
+            return;
+        }
+
+        consoleOut() << "Created new process: " << name << " (PID " << pid << ") with " << memory << " bytes and " << instructionCount << " instructions.\n";
+        consoleOut() << "Attached to process screen.\n";
         ensureSchedulerActive();
 
-        mode = ConsoleMode::PROCESS;
-        current_process = name;
+        session.mode = ConsoleMode::PROCESS;
+        session.current_process = name;
     }
     // --- Reattach to an existing process ---
     else if (flag == "-r" && args.size() >= 3) {
@@ -490,52 +786,58 @@ void handleScreenCommand(const std::vector<std::string>& args) {
         bool finished = false;
         int pid = 0;
         {
-            std::lock_guard<std::mutex> lock(processTableMutex);
-            Process* p = findProcess(name);
-            if (p) {
+            std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+            auto note = [&](const auto& p) {
                 found = true;
-                pid = p->pid;
-                finished = (p->state == ProcessState::FINISHED);
-            }
+                pid = p.pid;
+                finished = (p.state() == ProcessState::FINISHED);
+            };
+            if (const Process* p = emu().processTable.get(findProcess(name))) note(*p);
+            else if (const FinishedProcess* p = findFinishedProcess(name)) note(*p);
         }
 
         if (!found) {
-            std::cout << "Process " << name << " not found.\n";
+            consoleOut() << "Process " << name << " not found.\n";
             return;
         }
 
         if (finished) {
-            std::cout << "Process " << name << " already finished.\n";
+            consoleOut() << "Process " << name << " already finished.\n";
             return;
         }
 
-        std::cout << "Reattached to process " << name << " (PID " << pid << ")\n";
-        mode = ConsoleMode::PROCESS;
-        current_process = name;
+        consoleOut() << "Reattached to process " << name << " (PID " << pid << ")\n";
+        session.mode = ConsoleMode::PROCESS;
+        session.current_process = name;
     }
 
     // --- List all processes ---
     else if (flag == "-ls") {
         std::deque<Process> snapshot;
+        std::deque<FinishedProcess> finishedSnapshot;
         size_t rrCursorSnapshot = 0;
         {
-            std::lock_guard<std::mutex> lock(processTableMutex);
-            if (processTable.empty()) {
-                std::cout << "No processes created.\n";
+            std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+            if (emu().processTable.empty() && emu().finishedProcesses.empty()) {
+                consoleOut() << "No processes created.\n";
                 return;
             }
-            snapshot.assign(processTable.begin(), processTable.end());
-            rrCursorSnapshot = rrCursor;
+            snapshot.assign(emu().processTable.begin(), emu().processTable.end());
+            finishedSnapshot.assign(emu().finishedProcesses.begin(), emu().finishedProcesses.end());
+            rrCursorSnapshot = emu().rrCursor;
             if (!snapshot.empty()) {
                 rrCursorSnapshot %= snapshot.size();
             }
         }
 
-        int totalCores = systemConfig.num_cpu;
+        int totalCores = emu().systemConfig.num_cpu;
         int runningCount = 0, finishedCount = 0, readyCount = 0, sleepingCount = 0;
 
+        for (const auto& p : finishedSnapshot) {
+            if (p.state() == ProcessState::FINISHED) finishedCount++;
+        }
         for (const auto& p : snapshot) {
-            switch (p.state) {
+            switch (p.state()) {
             case ProcessState::RUNNING:   runningCount++; break;
             case ProcessState::READY:     readyCount++; break;
             case ProcessState::SLEEPING:  sleepingCount++; break;
@@ -547,42 +849,42 @@ void handleScreenCommand(const std::vector<std::string>& args) {
             ? (float)runningCount / totalCores * 100.0f
             : 0.0f;
 
-        std::cout << "\n=== CPU SUMMARY ===\n";
-        std::cout << "CPU Utilization: " << utilization << "%\n";
-        std::cout << "Cores Used: " << runningCount << "/" << totalCores << "\n";
-        std::cout << "Cores Available: " << (totalCores - runningCount) << "\n";
-        std::cout << "Ready: " << readyCount
+        consoleOut() << "\n=== CPU SUMMARY ===\n";
+        consoleOut() << "CPU Utilization: " << utilization << "%\n";
+        consoleOut() << "Cores Used: " << runningCount << "/" << totalCores << "\n";
+        consoleOut() << "Cores Available: " << (totalCores - runningCount) << "\n";
+        consoleOut() << "Ready: " << readyCount
             << " | Sleeping: " << sleepingCount
             << " | Finished: " << finishedCount << "\n";
 
-        std::cout << "\n=== PROCESS TABLE ===\n";
+        consoleOut() << "\n=== PROCESS TABLE ===\n";
 
         // Print all RUNNING and SLEEPING processes first
         for (const auto& p : snapshot) {
-            if (p.state == ProcessState::RUNNING || p.state == ProcessState::SLEEPING) {
-                std::string stateStr = (p.state == ProcessState::RUNNING ? "RUNNING" : "SLEEPING");
-                std::cout << "  " << p.name << " [PID " << p.pid << "] - "
-                    << stateStr << " (" << p.pc << "/" << p.instructions.size() << ")\n";
+            if (p.state() == ProcessState::RUNNING || p.state() == ProcessState::SLEEPING) {
+                std::string stateStr = (p.state() == ProcessState::RUNNING ? "RUNNING" : "SLEEPING");
+                consoleOut() << "  " << p.name << " [PID " << p.pid << "] - "
+                    << stateStr << " (" << p.pc << "/" << p.program->size() << ")\n";
             }
         }
 
         // Show next 4 READY processes based on actual scheduler order
         std::vector<Process*> readyList;
 
-        if (systemConfig.scheduler == "rr" && !snapshot.empty()) {
+        if (emu().systemConfig.scheduler == "rr" && !snapshot.empty()) {
             size_t total = snapshot.size();
             size_t added = 0;
             for (size_t offset = 0; offset < total && added < 4; ++offset) {
                 size_t idx = (rrCursorSnapshot + offset) % total;
-                if (snapshot[idx].state == ProcessState::READY) {
+                if (snapshot[idx].state() == ProcessState::READY) {
                     readyList.push_back(&snapshot[idx]);
                     added++;
                 }
             }
         }
-        else if (systemConfig.scheduler == "fcfs") {
+        else if (emu().systemConfig.scheduler == "fcfs") {
             for (auto& p : snapshot) {
-                if (p.state == ProcessState::READY) {
+                if (p.state() == ProcessState::READY) {
                     readyList.push_back(&p);
                     if (readyList.size() >= 4) break;
                 }
@@ -591,41 +893,187 @@ void handleScreenCommand(const std::vector<std::string>& args) {
 
         // Display the READY list
         for (auto* p : readyList) {
-            std::cout << "  " << p->name << " [PID " << p->pid << "] - READY ("
-                << p->pc << "/" << p->instructions.size() << ")\n";
+            consoleOut() << "  " << p->name << " [PID " << p->pid << "] - READY ("
+                << p->pc << "/" << p->program->size() << ")\n";
         }
 
         if (runningCount == 0 && sleepingCount == 0 && readyList.empty())
-            std::cout << "  (No active or upcoming processes)\n";
+            consoleOut() << "  (No active or upcoming processes)\n";
 
         bool printedFinished = false;
-        for (const auto& p : snapshot) {
-            if (p.state == ProcessState::FINISHED) {
+        for (const auto& p : finishedSnapshot) {
+            if (p.state() == ProcessState::FINISHED) {
                 if (!printedFinished) {
-                    std::cout << "\n=== COMPLETED PROCESSES ===\n";
+                    consoleOut() << "\n=== COMPLETED PROCESSES ===\n";
                     printedFinished = true;
                 }
-                std::cout << "  " << p.name << " [PID " << p.pid << "] - FINISHED ("
-                    << p.pc << "/" << p.instructions.size() << ")\n";
+                consoleOut() << "  " << p.name << " [PID " << p.pid << "] - FINISHED ("
+                    << p.pc << "/" << p.instructionCount() << ")\n";
             }
         }
         if (!printedFinished)
-            std::cout << "\n(No completed processes yet)\n";
+            consoleOut() << "\n(No completed processes yet)\n";
+
+
+        consoleOut() << "=====================\n\n";
+    }
+}
+
+// load-dir <dir> [memory]: one process per program file, mapped and parsed in parallel
+void loadDirCommand(const std::vector<std::string>& args) {
+    if (!emu().initialized) {
+        consoleOut() << "Error: System not initialized. Type 'initialize' first.\n";
+        return;
+    }
+    if (args.size() < 2 || args.size() > 3) {
+        consoleOut() << "Usage: load-dir <directory> [memory]\n";
+        return;
+    }
+
+    int memory = static_cast<int>(emu().systemConfig.max_mem_per_proc);
+    if (args.size() == 3 && !parseProcessMemory(args[2], memory)) return;
+
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(args[1], ec)) {
+        if (entry.is_regular_file()) paths.push_back(entry.path().string());
+    }
+    if (ec) {
+        consoleOut() << "Error: cannot read directory " << args[1] << "\n";
+        return;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<LoadedProgram> programs = loadProgramsParallel(paths, sharedThreadPool(), emu().systemConfig.program_cache);
+    auto parsed = std::chrono::steady_clock::now();
+
+    size_t created = 0, failed = 0, instructionCount = 0, cached = 0;
+    for (auto& program : programs) {
+        if (!program.error.empty()) {
+            consoleOut() << "  Skipped " << program.path << ": " << program.error << "\n";
+            failed++;
+            continue;
+        }
+        size_t count = program.instructions.size();
+        if (createProcess(program.name, memory, std::move(program.instructions)) < 0) {
+            consoleOut() << "  Skipped " << program.path << ": process " << program.name << " already exists\n";
+            failed++;
+            continue;
+        }
+        created++;
+        instructionCount += count;
+        if (program.cached) cached++;
+    }
 
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(parsed - start).count();
+    consoleOut() << "Loaded " << created << " process(es) with " << instructionCount << " instructions from "
+        << args[1] << " (" << failed << " skipped, " << cached << " from cache, parsed in " << ms << " ms on "
+        << sharedThreadPool().size() << " threads).\n";
+    if (created > 0) ensureSchedulerActive();
+}
 
-        std::cout << "=====================\n\n";
+// perf-report [reset]: host-time latency percentiles per instrumented point
+void perfReportCommand(const std::vector<std::string>& args) {
+#ifdef CSOPESY_NO_PERF
+    consoleOut() << "Perf instrumentation was compiled out (CSOPESY_NO_PERF).\n";
+#else
+    if (args.size() == 2 && args[1] == "reset") {
+        resetPerfStats();
+        consoleOut() << "Perf histograms cleared.\n";
+        return;
+    }
+    std::string report = perfReport();
+    consoleOut() << "\n=== PERF REPORT (host time) ===\n" << report;
+    consoleOut() << "===============================\n\n";
+#endif
+}
+
+// lockstat [reset]: acquisitions, contention, wait and hold time per named lock
+void lockStatCommand(const std::vector<std::string>& args) {
+#ifdef CSOPESY_NO_PERF
+    consoleOut() << "Lock instrumentation was compiled out (CSOPESY_NO_PERF).\n";
+#else
+    if (args.size() == 2 && args[1] == "reset") {
+        resetLockStats();
+        consoleOut() << "Lock statistics cleared.\n";
+        return;
     }
+    std::string report = lockStatReport();
+    consoleOut() << "\n=== LOCK STATISTICS ===\n" << report;
+    consoleOut() << "=======================\n\n";
+#endif
+}
+
+// optimize <process> [tick-accurate|full]: runs the optimizer over the rest of one
+// process's program, from its pc on
+void optimizeCommand(const std::vector<std::string>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        consoleOut() << "Usage: optimize <process_name> [tick-accurate|full]\n";
+        return;
+    }
+    OptimizeMode mode = OptimizeMode::TICK_ACCURATE;
+    if (args.size() == 3 && (!parseOptimizeMode(args[2], mode) || mode == OptimizeMode::OFF)) {
+        consoleOut() << "Error: Unknown optimize mode '" << args[2] << "'. Use tick-accurate or full.\n";
+        return;
+    }
+
+    // The caller holds tickMutex, so the process is not mid-instruction
+    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+    Process* p = emu().processTable.get(findProcess(args[1]));
+    if (!p) {
+        consoleOut() << "Process " << args[1] << " not found.\n";
+        return;
+    }
+    if (p->state() == ProcessState::FINISHED || p->state() == ProcessState::MEMORY_VIOLATED) {
+        consoleOut() << "Process " << args[1] << " has already ended.\n";
+        return;
+    }
+    // Copy on write: the image stays shared with other processes running it
+    InstructionList code(p->program->begin(), p->program->end());
+    OptimizeStats stats = optimizeProgram(code, p->pc, p->symbol_table, mode);
+    const size_t before = p->program->size() - p->pc;
+    if (stats.folded || stats.eliminated || stats.loops) p->program = ProgramImage::intern(std::move(code));
+    consoleOut() << "Optimized " << p->name << " from instruction " << p->pc << ": "
+        << before << " -> " << p->program->size() - p->pc << " instructions ("
+        << stats.folded << " folded, " << stats.eliminated << " dead stores, "
+        << stats.loops << " empty loops).\n";
+}
+
+// control-socket <path> | control-socket stop
+void controlSocketCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        consoleOut() << "Usage: control-socket <path> | control-socket stop\n";
+        if (controlServer.running()) consoleOut() << "Listening on " << controlServer.socketPath() << "\n";
+        return;
+    }
+    if (args[1] == "stop") {
+        if (!controlServer.running()) {
+            consoleOut() << "Control socket is not running.\n";
+            return;
+        }
+        controlServer.stop();
+        consoleOut() << "Control socket stopped.\n";
+        return;
+    }
+
+    std::string error;
+    if (!controlServer.start(args[1], error)) {
+        consoleOut() << "Error: " << error << "\n";
+        return;
+    }
+    consoleOut() << "Control socket listening on " << args[1] << "\n";
 }
 
 // Scheduler-start/stop command handler
 void handleSchedulerCommand(const std::vector<std::string>& args) {
-    if (!initialized) {
-        std::cout << "Error: System not initialized. Type 'initialize' first.\n";
+    if (!emu().initialized) {
+        consoleOut() << "Error: System not initialized. Type 'initialize' first.\n";
         return;
     }
 
     if (args.size() == 1) {
-        std::cout << "Usage:\n"
+        consoleOut() << "Usage:\n"
             << "  scheduler start\n"
             << "  scheduler stop\n";
         return;
@@ -634,32 +1082,34 @@ void handleSchedulerCommand(const std::vector<std::string>& args) {
     const std::string& subcmd = args[1];
 
     if (subcmd == "start") {
-        if (autoCreateRunning.load()) {
-            std::cout << "Auto-creation is already running (every "
-                << systemConfig.batch_process_freq << " tick"
-                << (systemConfig.batch_process_freq == 1 ? "" : "s") << ").\n";
+        if (emu().autoCreateRunning.load()) {
+            consoleOut() << "Auto-creation is already running (every "
+                << emu().systemConfig.batch_process_freq << " tick"
+                << (emu().systemConfig.batch_process_freq == 1 ? "" : "s") << ").\n";
             // Still ensure the scheduler thread is alive.
             ensureSchedulerActive();
             return;
         }
-        autoCreateRunning.store(true);
+        emu().autoCreateRunning.store(true);
+        emu().processGenerator.start();
 
         ensureSchedulerActive();
 
-        std::cout << "Auto-creation started new process every "
-            << systemConfig.batch_process_freq << " tick"
-            << (systemConfig.batch_process_freq == 1 ? "" : "s") << ".\n";
+        consoleOut() << "Auto-creation started new process every "
+            << emu().systemConfig.batch_process_freq << " tick"
+            << (emu().systemConfig.batch_process_freq == 1 ? "" : "s") << ".\n";
     }
     else if (subcmd == "stop") {
-        if (!autoCreateRunning.load()) {
-            std::cout << "Auto-creation is not running.\n";
+        if (!emu().autoCreateRunning.load()) {
+            consoleOut() << "Auto-creation is not running.\n";
             return;
         }
-        autoCreateRunning.store(false);
-        std::cout << "Auto-creation stopped.\n";
+        emu().autoCreateRunning.store(false);
+        emu().processGenerator.stop();
+        consoleOut() << "Auto-creation stopped.\n";
     }
     else {
-        std::cout << "Invalid command. Use 'scheduler start' or 'scheduler stop'.\n";
+        consoleOut() << "Invalid command. Use 'scheduler start' or 'scheduler stop'.\n";
     }
 }
 
@@ -667,157 +1117,154 @@ void handleSchedulerCommand(const std::vector<std::string>& args) {
 // scheduler-start
 // === Multi-core scheduler (RR / FCFS) ===
 void scheduler_loop_tick(bool hasActiveWork) {
+    Emulator& sim = emu(); // resolved once; the tick touches instance state throughout
     const auto activeTickDelay = std::chrono::milliseconds(5);
     const auto idleTickDelay = std::chrono::milliseconds(100);
 
-    std::this_thread::sleep_for(hasActiveWork ? activeTickDelay : idleTickDelay);
-    global_tick++;
+    if (sim.throttleTicks) {
+        std::this_thread::sleep_for(hasActiveWork ? activeTickDelay : idleTickDelay);
+    }
+    std::lock_guard<InstrumentedMutex> tickLock(sim.tickMutex);
+    sim.global_tick++;
+    PERF_SCOPE(tickScope, PerfPoint::SCHEDULER_TICK);
 
     auto assignReadyToIdleCores = [&]() {
-        size_t tableSize = processTable.size();
+        size_t tableSize = sim.processTable.slotCount();
         if (tableSize == 0) {
-            rrCursor = 0;
+            sim.rrCursor = 0;
         }
 
-        for (auto& core : cpuCores) {
+        for (auto& core : sim.cpuCores) {
             if (core.running) {
                 continue;
             }
 
-            tableSize = processTable.size();
+            tableSize = sim.processTable.slotCount();
             if (tableSize == 0) {
-                rrCursor = 0;
-                core.running = nullptr;
+                sim.rrCursor = 0;
+                core.running = ProcessHandle{};
                 continue;
             }
 
-            if (systemConfig.scheduler == "rr" && tableSize > 0 && rrCursor >= tableSize) {
-                rrCursor %= tableSize;
+            if (sim.systemConfig.scheduler == "rr" && tableSize > 0 && sim.rrCursor >= tableSize) {
+                sim.rrCursor %= tableSize;
             }
 
-            size_t chosenIndex = tableSize;
-            if (systemConfig.scheduler == "rr") {
-                for (size_t offset = 0; offset < tableSize; ++offset) {
-                    size_t idx = (rrCursor + offset) % tableSize;
-                    if (processTable[idx].state == ProcessState::READY) {
-                        chosenIndex = idx;
-                        rrCursor = (idx + 1) % tableSize;
-                        break;
-                    }
-                }
-            }
-            else {
-                for (size_t idx = 0; idx < tableSize; ++idx) {
-                    if (processTable[idx].state == ProcessState::READY) {
-                        chosenIndex = idx;
-                        break;
-                    }
-                }
+            size_t chosenIndex = (sim.systemConfig.scheduler == "rr")
+                ? sim.processTable.nextReady(sim.rrCursor, true)
+                : sim.processTable.nextReady(0, false);
+            if (sim.systemConfig.scheduler == "rr" && chosenIndex != tableSize) {
+                sim.rrCursor = (chosenIndex + 1) % tableSize;
             }
 
             if (chosenIndex != tableSize) {
-                core.running = &processTable[chosenIndex];
-                processTable[chosenIndex].state = ProcessState::RUNNING;
-                core.quantum_left = (systemConfig.scheduler == "rr")
-                    ? systemConfig.quantum_cycles
+                core.running = sim.processTable.handleAt(chosenIndex);
+                sim.processTable.states[chosenIndex] = ProcessState::RUNNING;
+                core.quantum_left = (sim.systemConfig.scheduler == "rr")
+                    ? sim.systemConfig.quantum_cycles
                     : 0;
             }
         }
         };
 
     // === 1. Wake up sleeping processes ===
-    for (auto& p : processTable) {
-        if (p.state == ProcessState::SLEEPING && p.sleep_counter > 0) {
-            p.sleep_counter--;
-            if (p.sleep_counter == 0) {
-                p.state = ProcessState::READY;
-            }
-        }
-    }
+    sim.processTable.wakeSleepers();
 
     // === 2. Assign ready processes to idle cores ===
-    for (auto& core : cpuCores) {
-        if (!core.running || core.running->state == ProcessState::FINISHED) {
-            core.running = nullptr;
+    for (auto& core : sim.cpuCores) {
+        Process* current = sim.processTable.get(core.running);
+        if (!current || current->state() == ProcessState::FINISHED) {
+            core.running = ProcessHandle{}; // idle, finished or retired
         }
     }
 
     assignReadyToIdleCores();
 
     // === 3. Execute processes on each core ===
+    // One instruction = one tick. In quantum mode each core instead runs up to its
+    // remaining quantum in one slice, and the round covers as many ticks as the
+    // longest slice; instruction i of a slice runs at tick roundStart + i. Ticks a bulk
+    // transfer owes past its own keep the core busy the same way an instruction does.
+    const bool sliced = sim.systemConfig.exec_mode == "quantum";
+    const unsigned long long roundStart = sim.global_tick;
+    int roundTicks = 1;
     bool rescheduleNeeded = false;
-    for (auto& core : cpuCores) {
-        if (core.running && core.running->state == ProcessState::RUNNING) {
-            Process* p = core.running;
-
-            // Execute one instruction = one tick
-            if (p->pc < p->instructions.size()) {
-                auto currentInstr = p->instructions[p->pc];
-                logInstructionTrace(*p, currentInstr);
-                currentInstr->execute(*p);
-
-                if (systemConfig.scheduler == "rr") {
-                    core.quantum_left--;
+    std::vector<ProcessHandle> ended; // retired once every core has run
+    for (auto& core : sim.cpuCores) {
+        Process* p = sim.processTable.get(core.running);
+        if (p && p->state() == ProcessState::RUNNING) {
+
+            if (p->pc < p->program->size() || p->busy_ticks > 0) {
+                int budget = 1;
+                if (sliced) {
+                    budget = (sim.systemConfig.scheduler == "rr") ? core.quantum_left : sim.systemConfig.quantum_cycles;
+                    budget = std::max(budget, 1);
+                }
+                SliceResult slice = runSlice(*p, budget, roundStart);
+                const int ticks = slice.ticks(); // instructions plus bulk-transfer ticks
+                roundTicks = std::max(roundTicks, ticks);
+                sim.instructionsExecuted += slice.executed;
+                sim.busyCoreTicks += ticks;
+
+                // The rest of the round is counted off every sleeper at once below, so
+                // credit the ticks that passed before this one fell asleep
+                if (slice.exit == SliceExit::SLEEP && p->sleepCounter() > 0) {
+                    p->setSleepCounter(p->sleepCounter() + ticks - 1);
+                }
+
+                if (sim.systemConfig.scheduler == "rr") {
+                    core.quantum_left -= ticks;
                 }
 
                 // Handle post-execution logic
-                if (p->state == ProcessState::FINISHED) {
-                core.running = nullptr;
+                if (p->state() == ProcessState::FINISHED) {
+                ended.push_back(core.running);
+                core.running = ProcessHandle{};
                 rescheduleNeeded = true;
                 }
-                else if (p->state == ProcessState::MEMORY_VIOLATED) {
+                else if (p->state() == ProcessState::MEMORY_VIOLATED) {
                     // Log the violation to console
-                    std::cout << "Process " << p->name << " (" << p->pid << ") terminated due to Memory Violation.\n";
-                    core.running = nullptr; // Release the core
+                    consoleOut() << "Process " << p->name << " (" << p->pid << ") terminated due to Memory Violation.\n";
+                    ended.push_back(core.running);
+                    core.running = ProcessHandle{}; // Release the core
                     rescheduleNeeded = true;
                 }
-                else if (p->pc >= p->instructions.size()) {
-                    p->state = ProcessState::FINISHED;
-                    core.running = nullptr;
+                else if (p->pc >= p->program->size() && p->busy_ticks == 0) {
+                    p->setState(ProcessState::FINISHED);
+                    p->finish_tick = roundStart + ticks - 1;
+                    ended.push_back(core.running);
+                    core.running = ProcessHandle{};
                     rescheduleNeeded = true;
                 }
-                else if (p->state == ProcessState::SLEEPING) {
-                    core.running = nullptr;
+                else if (p->state() == ProcessState::SLEEPING) {
+                    core.running = ProcessHandle{};
                     rescheduleNeeded = true;
                 }
-                else if (systemConfig.scheduler == "rr" &&
+                else if (sim.systemConfig.scheduler == "rr" &&
                     core.quantum_left <= 0) {
                     // Quantum expired — check if another READY process exists
-                    bool hasOtherReady = std::any_of(processTable.begin(), processTable.end(),
-                        [&](const Process& other) {
-                            return other.state == ProcessState::READY &&
-                                &other != p;
-                        });
+                    bool hasOtherReady = sim.processTable.anyReadyExcept(p->slot());
 
                     if (hasOtherReady) {
-                        p->state = ProcessState::READY;
-                        core.running = nullptr; // Preempt
+                        p->setState(ProcessState::READY);
+                        core.running = ProcessHandle{}; // Preempt
                         rescheduleNeeded = true;
-                        core.quantum_left = systemConfig.quantum_cycles;
-
-                        auto it = std::find_if(processTable.begin(), processTable.end(),
-                            [&](Process& candidate) { return &candidate == p; });
-                        if (it != processTable.end()) {
-                            size_t idx = static_cast<size_t>(std::distance(processTable.begin(), it));
-                            size_t tableSize = processTable.size();
-                            if (tableSize > 0) {
-                                rrCursor = (idx + 1) % tableSize;
-                            }
-                            else {
-                                rrCursor = 0;
-                            }
-                        }
+                        core.quantum_left = sim.systemConfig.quantum_cycles;
+
+                        sim.rrCursor = (p->slot() + 1) % sim.processTable.slotCount();
                     }
                     else {
                         // No other ready — keep executing
-                        core.quantum_left = systemConfig.quantum_cycles;
+                        core.quantum_left = sim.systemConfig.quantum_cycles;
                     }
                 }
             }
             else {
                 // PC out of bounds, finish
-                p->state = ProcessState::FINISHED;
-                core.running = nullptr;
+                p->setState(ProcessState::FINISHED);
+                p->finish_tick = sim.global_tick;
+                ended.push_back(core.running);
+                core.running = ProcessHandle{};
                 rescheduleNeeded = true;
             }
         }
@@ -826,85 +1273,88 @@ void scheduler_loop_tick(bool hasActiveWork) {
         }
     }
 
+    for (ProcessHandle h : ended) retireProcess(h);
+
+    // Quantum mode: advance the clock over the rest of the round in one step
+    if (roundTicks > 1) {
+        sim.global_tick += roundTicks - 1;
+        sim.processTable.wakeSleepers(roundTicks - 1);
+        rescheduleNeeded = true;
+    }
+
     if (rescheduleNeeded) {
         assignReadyToIdleCores();
     }
 
-    // === 4. Auto-create processes if enabled ===
-    if (autoCreateRunning.load() &&
-        systemConfig.batch_process_freq > 0 &&
-        global_tick % systemConfig.batch_process_freq == 0) {
-
-        // Only create one process per batch frequency, not potentially multiple
-        static unsigned long long lastCreationTick = 0;
-
-        static auto lastCreationWallClock = std::chrono::steady_clock::now();
-        const auto creationCooldown = std::chrono::milliseconds(100);
-
-        const auto now = std::chrono::steady_clock::now();
-        if (global_tick != lastCreationTick && now - lastCreationWallClock >= creationCooldown) {
-            Process newProc;
-            newProc.name = "auto_p" + std::to_string(nextPID++);
-            newProc.pid = nextPID - 1;
-            newProc.state = ProcessState::READY;
-            int insCount = rand() % (systemConfig.max_ins - systemConfig.min_ins + 1) + systemConfig.min_ins;
-            
-            // Memory Allocation
-            size_t memSize = rand() % (systemConfig.max_mem_per_proc - systemConfig.min_mem_per_proc + 1) + systemConfig.min_mem_per_proc;
-            newProc.memory_required = memSize;
-            newProc.instructions = generateDummyInstructions(insCount, (int)memSize);
-            int pages = (memSize + systemConfig.mem_per_frame - 1) / systemConfig.mem_per_frame;
-            memoryManager->initializePageTable(newProc, pages);
-            
-            processTable.push_back(newProc);
-
-            lastCreationWallClock = now;
+    // === 4. Admit one pre-built process per batch frequency ===
+    // The generator thread does the expensive building; the interactive scheduler never
+    // waits for it, while unthrottled and recorded runs block so every batch slot is filled.
+    // A multi-tick round admits one process for every batch tick it covered.
+    if (sim.autoCreateRunning.load() && sim.systemConfig.batch_process_freq > 0) {
+        const unsigned long long freq = static_cast<unsigned long long>(sim.systemConfig.batch_process_freq);
+        unsigned long long due = sim.global_tick / freq - (roundStart - 1) / freq;
+        for (; due > 0; --due) {
+            Process newProc(sim.processTable.resource());
+            if (!sim.processGenerator.pop(newProc, !sim.throttleTicks || sim.recorder.active())) break;
+            admitGeneratedProcess(std::move(newProc));
         }
     }
+
+    // === 5. Periodic metrics sample ===
+    sim.metricsExporter.onTick(static_cast<unsigned long long>(roundTicks));
+}
+
+// Names a generator-built process, gives it a pid and adds it to the table
+void admitGeneratedProcess(Process&& newProc) {
+    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+    newProc.pid = emu().nextPID++;
+    newProc.name = "auto_p" + std::to_string(newProc.pid);
+    newProc.arrival_tick = emu().global_tick;
+    emu().processTable.insert(std::move(newProc));
 }
 
 // report-util 
 void reportUtilCommand()
 {
-    if (!initialized)
+    if (!emu().initialized)
     {
-        std::cout << "Error: System not initialized. Type 'initialize' first.\n";
+        consoleOut() << "Error: System not initialized. Type 'initialize' first.\n";
         return;
     }
 
     int running = 0, ready = 0, sleeping = 0, finished = 0;
     {
-        std::lock_guard<std::mutex> lock(processTableMutex);
-        for (auto& p : processTable)
+        std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+        emu().forEachProcess([&](const auto& p)
         {
-            switch (p.state)
+            switch (p.state())
             {
             case ProcessState::RUNNING:   running++; break;
             case ProcessState::READY:     ready++; break;
             case ProcessState::SLEEPING:  sleeping++; break;
             case ProcessState::FINISHED:  finished++; break;
             }
-        }
+        });
     }
 
-    float utilization = (systemConfig.num_cpu > 0)
-        ? (float)running / systemConfig.num_cpu * 100.0f
+    float utilization = (emu().systemConfig.num_cpu > 0)
+        ? (float)running / emu().systemConfig.num_cpu * 100.0f
         : 0.0f;
 
-    std::cout << "\n=== CPU UTILIZATION REPORT ===\n";
-    std::cout << "CPU Utilization: " << utilization << "%\n";
-    std::cout << "Cores Used: " << running << "/" << systemConfig.num_cpu << "\n";
-    std::cout << "Ready: " << ready
+    consoleOut() << "\n=== CPU UTILIZATION REPORT ===\n";
+    consoleOut() << "CPU Utilization: " << utilization << "%\n";
+    consoleOut() << "Cores Used: " << running << "/" << emu().systemConfig.num_cpu << "\n";
+    consoleOut() << "Ready: " << ready
         << " | Sleeping: " << sleeping
         << " | Finished: " << finished << "\n";
 
     {
-        std::lock_guard<std::mutex> lock(processTableMutex);
-        std::cout << "\n=== PROCESS DETAILS ===\n";
-        for (auto& p : processTable)
+        std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+        consoleOut() << "\n=== PROCESS DETAILS ===\n";
+        emu().forEachProcess([](const auto& p)
         {
             std::string stateStr;
-            switch (p.state)
+            switch (p.state())
             {
             case ProcessState::READY:     stateStr = "READY"; break;
             case ProcessState::RUNNING:   stateStr = "RUNNING"; break;
@@ -913,40 +1363,40 @@ void reportUtilCommand()
             default:                      stateStr = "UNKNOWN"; break;
             }
 
-            std::cout << "  " << p.name
+            consoleOut() << "  " << p.name
                 << " [PID " << p.pid << "] - " << stateStr
-                << " (" << p.pc << "/" << p.instructions.size() << ")\n";
-        }
-        std::cout << "===============================\n";
+                << " (" << p.pc << "/" << p.instructionCount() << ")\n";
+        });
+        consoleOut() << "===============================\n";
     }
 
-    std::cout << "Report saved to csopesy-log.txt\n";
-    std::cout << "===============================\n\n";
+    consoleOut() << "Report saved to csopesy-log.txt\n";
+    consoleOut() << "===============================\n\n";
 
     std::ofstream log("csopesy-log.txt");
     if (!log.is_open())
     {
-        std::cout << "Error: Unable to create csopesy-log.txt\n";
+        consoleOut() << "Error: Unable to create csopesy-log.txt\n";
         return;
     }
 
     log << "=== CSOPESY CPU UTILIZATION REPORT ===\n";
     log << "CPU Utilization: " << utilization << "%\n";
-    log << "Cores Used: " << running << "/" << systemConfig.num_cpu << "\n";
+    log << "Cores Used: " << running << "/" << emu().systemConfig.num_cpu << "\n";
     log << "Ready: " << ready
         << " | Sleeping: " << sleeping
         << " | Finished: " << finished << "\n";
     log << "======================================\n";
 
-    std::lock_guard<std::mutex> lock(processTableMutex);
-    if (processTable.empty()) {
+    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+    if (emu().processTable.empty() && emu().finishedProcesses.empty()) {
         log << "No processes created.\n";
     }
     else {
         log << "=== PROCESS TABLE ===\n";
-        for (const auto& p : processTable) {
+        emu().forEachProcess([&](const auto& p) {
             std::string stateStr;
-            switch (p.state) {
+            switch (p.state()) {
             case ProcessState::RUNNING:   stateStr = "RUNNING"; break;
             case ProcessState::READY:     stateStr = "READY"; break;
             case ProcessState::SLEEPING:  stateStr = "SLEEPING"; break;
@@ -954,138 +1404,144 @@ void reportUtilCommand()
             }
 
             log << "  " << p.name << " [PID " << p.pid << "] - "
-                << stateStr << " (" << p.pc << "/" << p.instructions.size() << ")\n";
-        }
+                << stateStr << " (" << p.pc << "/" << p.instructionCount() << ")\n";
+        });
         log << "=====================\n";
     }
 
     log.close();
 }
 
-// process-smi inside process screen
-void processSmiCommand() {
-    Process procSnapshot;
-    bool found = false;
-    {
-        std::lock_guard<std::mutex> lock(processTableMutex);
-        Process* proc = findProcess(current_process);
-        if (proc) {
-            found = true;
-            procSnapshot = *proc; // Copy
-        }
-    }
-
-    if (!found) {
-        std::cout << "Error: Process " << current_process << " not found.\n";
-        return;
-    }
-
-    std::cout << "\n=== Process SMI ===\n";
-    std::cout << "Name: " << procSnapshot.name << "\n";
-    std::cout << "PID: " << procSnapshot.pid << "\n";
+// Prints a process-smi report from a snapshot taken under processTableMutex; P is
+// Process or FinishedProcess
+template <typename P>
+static void printProcessSmi(const P& procSnapshot) {
+    consoleOut() << "\n=== Process SMI ===\n";
+    consoleOut() << "Name: " << procSnapshot.name << "\n";
+    consoleOut() << "PID: " << procSnapshot.pid << "\n";
 
     // Translate enum to string
     std::string stateStr;
-    switch (procSnapshot.state) {
+    switch (procSnapshot.state()) {
     case ProcessState::READY: stateStr = "READY"; break;
     case ProcessState::RUNNING: stateStr = "RUNNING"; break;
     case ProcessState::SLEEPING: stateStr = "SLEEPING"; break;
     case ProcessState::FINISHED: stateStr = "FINISHED"; break;
     case ProcessState::MEMORY_VIOLATED: stateStr = "MEMORY_VIOLATED"; break;
     }
-    std::cout << "State: " << stateStr << "\n";
+    consoleOut() << "State: " << stateStr << "\n";
 
     // Instruction progress
-    std::cout << "Instruction progress: " << procSnapshot.pc << " / " << procSnapshot.instructions.size() << "\n";
+    consoleOut() << "Instruction progress: " << procSnapshot.pc << " / " << procSnapshot.instructionCount() << "\n";
 
     // === Display Variables with Values from Memory ===
     if (!procSnapshot.symbol_table.empty()) {
-        std::cout << "Variables (Stored in Page 0):\n";
-        for (const auto& [name, addr] : procSnapshot.symbol_table) {
-            std::cout << "  " << name << " @ Address " << addr;
+        consoleOut() << "Variables (Stored in Page 0):\n";
+        for (size_t slot = 0; slot < procSnapshot.symbol_table.size(); ++slot) {
+            const std::string& name = symbolName(procSnapshot.symbol_table.idAt(slot));
+            int addr = static_cast<int>(slot * SymbolTable::VAR_SIZE);
+            consoleOut() << "  " << name << " @ Address " << addr;
 
             // Check if the page containing this variable is currently in RAM
-            if (memoryManager->isPageResident(procSnapshot.pid, addr)) {
+            if (emu().memoryManager->isPageResident(procSnapshot.pid, addr)) {
                 int val = 0;
                 // Attempt to read the value (this updates LRU but that is acceptable)
-                if (memoryManager->access(procSnapshot.pid, addr, false, val)) {
-                    std::cout << " = " << val;
+                if (emu().memoryManager->access(procSnapshot.pid, addr, false, val)) {
+                    consoleOut() << " = " << val;
                 }
                 else {
-                    std::cout << " = (Error reading)";
+                    consoleOut() << " = (Error reading)";
                 }
             }
             else {
                 // If the page is not in RAM, we show this tag. 
                 // This adds realism: you can't see the value because it's on the 'disk'.
-                std::cout << " = [Swapped Out]";
+                consoleOut() << " = [Swapped Out]";
             }
-            std::cout << "\n";
+            consoleOut() << "\n";
         }
     }
     else {
-        std::cout << "Variables: (none)\n";
+        consoleOut() << "Variables: (none)\n";
     }
 
     // Display logs
     if (!procSnapshot.logs.empty()) {
-        std::cout << "Logs:\n";
+        consoleOut() << "Logs:\n";
         for (const auto& log : procSnapshot.logs)
-            std::cout << "  " << log << "\n";
+            consoleOut() << "  " << log << "\n";
     }
     else {
-        std::cout << "Logs: (none)\n";
+        consoleOut() << "Logs: (none)\n";
     }
 
-    if (procSnapshot.state == ProcessState::FINISHED)
-        std::cout << "Process has finished execution.\n";
+    if (procSnapshot.state() == ProcessState::FINISHED)
+        consoleOut() << "Process has finished execution.\n";
 
     // Display Page Table
-    std::cout << "\n--- Page Table ---\n";
-    std::cout << "Total Frames: " << memoryManager->getTotalFrames() << "\n";
-    std::cout << "Free Frames: " << memoryManager->getFreeFrameCount() << "\n";
-    std::cout << "Page | Frame | Valid | Dirty | Last Accessed\n";
-    for (const auto& [page, entry] : procSnapshot.page_table) {
-        std::cout << "  " << page << "  | "
-            << (entry.valid ? std::to_string(entry.frame_num) : "-") << "   | "
-            << (entry.valid ? "Yes" : "No ") << "   | "
-            << (entry.dirty ? "Yes" : "No ") << "   | "
-            << entry.last_accessed << "\n";
-    }
-
-    std::cout << "=====================\n\n";
+    consoleOut() << "\n--- Page Table ---\n";
+    consoleOut() << "Total Frames: " << emu().memoryManager->getTotalFrames() << "\n";
+    consoleOut() << "Free Frames: " << emu().memoryManager->getFreeFrameCount() << "\n";
+    consoleOut() << "Page | Frame | Valid | Dirty | Last Accessed\n";
+    if constexpr (std::is_same_v<P, Process>) { // a finished process has handed its pages back
+        for (const auto& [page, entry] : procSnapshot.page_table) {
+            consoleOut() << "  " << page << "  | "
+                << (entry.valid ? std::to_string(entry.frame_num) : "-") << "   | "
+                << (entry.valid ? "Yes" : "No ") << "   | "
+                << (entry.dirty ? "Yes" : "No ") << "   | "
+                << entry.last_accessed << "\n";
+        }
+    }
+
+    consoleOut() << "=====================\n\n";
+}
+
+// process-smi inside process screen
+void processSmiCommand(const Session& session) {
+    std::optional<Process> live;
+    std::optional<FinishedProcess> finished;
+    {
+        std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+        if (const Process* proc = emu().processTable.get(findProcess(session.current_process))) live = *proc; // Copy
+        else if (const FinishedProcess* proc = findFinishedProcess(session.current_process)) finished = *proc;
+    }
+
+    if (live) printProcessSmi(*live);
+    else if (finished) printProcessSmi(*finished);
+    else consoleOut() << "Error: Process " << session.current_process << " not found.\n";
 }
 
 void vmstatCommand() {
-    if (!initialized || !memoryManager) {
-        std::cout << "Error: System not initialized.\n";
+    if (!emu().initialized || !emu().memoryManager) {
+        consoleOut() << "Error: System not initialized.\n";
         return;
     }
 
-    size_t total_mem = systemConfig.max_overall_mem;
-    size_t used_mem = memoryManager->getUsedMemory();
+    size_t total_mem = emu().systemConfig.max_overall_mem;
+    size_t used_mem = emu().memoryManager->getUsedMemory();
     size_t free_mem = total_mem - used_mem;
 
     // Mock CPU ticks (since we don't track them granularly yet)
-    unsigned long long idle_ticks = global_tick * systemConfig.num_cpu; // Simplification
-    unsigned long long active_ticks = global_tick; // Simplification
-
-    VMStatCounters stats = memoryManager->getVMStat();
-
-    std::cout << "\n=== VMSTAT ===\n";
-    std::cout << total_mem << " K total memory\n";
-    std::cout << used_mem << " K used memory\n";
-    std::cout << free_mem << " K free memory\n";
-    std::cout << idle_ticks << " idle cpu ticks\n";
-    std::cout << active_ticks << " active cpu ticks\n";
-    std::cout << stats.pages_paged_in << " pages paged in\n";
-    std::cout << stats.pages_paged_out << " pages paged out\n";
-    std::cout << "=================\n\n";
+    unsigned long long idle_ticks = emu().global_tick * emu().systemConfig.num_cpu; // Simplification
+    unsigned long long active_ticks = emu().global_tick; // Simplification
+
+    VMStatCounters stats = emu().memoryManager->getVMStat();
+
+    consoleOut() << "\n=== VMSTAT ===\n";
+    consoleOut() << total_mem << " K total memory\n";
+    consoleOut() << used_mem << " K used memory\n";
+    consoleOut() << free_mem << " K free memory\n";
+    consoleOut() << idle_ticks << " idle cpu ticks\n";
+    consoleOut() << active_ticks << " active cpu ticks\n";
+    consoleOut() << stats.pages_paged_in << " pages paged in\n";
+    consoleOut() << stats.pages_paged_out << " pages paged out\n";
+    consoleOut() << ProgramImage::internedCount() << " shared program images\n";
+    consoleOut() << "=================\n\n";
 }
 
 void processSmiGlobal() {
-    if (!initialized || !memoryManager) {
-        std::cout << "Error: System not initialized.\n";
+    if (!emu().initialized || !emu().memoryManager) {
+        consoleOut() << "Error: System not initialized.\n";
         return;
     }
 
@@ -1093,23 +1549,23 @@ void processSmiGlobal() {
     std::deque<Process> snapshot;
     size_t rrCursorSnapshot = 0;
     {
-        std::lock_guard<std::mutex> lock(processTableMutex);
-        if (processTable.empty()) {
-            std::cout << "No processes created.\n";
+        std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+        if (emu().processTable.empty() && emu().finishedProcesses.empty()) {
+            consoleOut() << "No processes created.\n";
             return;
         }
-        snapshot.assign(processTable.begin(), processTable.end());
-        rrCursorSnapshot = rrCursor;
+        snapshot.assign(emu().processTable.begin(), emu().processTable.end());
+        rrCursorSnapshot = emu().rrCursor;
         if (!snapshot.empty()) {
             rrCursorSnapshot %= snapshot.size();
         }
     }
 
-    int totalCores = systemConfig.num_cpu;
+    int totalCores = emu().systemConfig.num_cpu;
     int runningCount = 0, finishedCount = 0, readyCount = 0, sleepingCount = 0;
 
-    size_t total_mem = systemConfig.max_overall_mem;
-    size_t used_mem = memoryManager->getUsedMemory();
+    size_t total_mem = emu().systemConfig.max_overall_mem;
+    size_t used_mem = emu().memoryManager->getUsedMemory();
     size_t free_mem = total_mem - used_mem;
 
     struct ProcSummary {
@@ -1135,7 +1591,7 @@ void processSmiGlobal() {
         }
 
         std::string stateStr;
-        switch (p.state) {
+        switch (p.state()) {
         case ProcessState::READY:          stateStr = "READY"; break;
         case ProcessState::RUNNING:        stateStr = "RUNNING"; break;
         case ProcessState::SLEEPING:       stateStr = "SLEEPING"; break;
@@ -1144,7 +1600,7 @@ void processSmiGlobal() {
         default:                           stateStr = "UNKNOWN"; break;
         }
 
-        size_t ramUsed = static_cast<size_t>(resident) * systemConfig.mem_per_frame;
+        size_t ramUsed = static_cast<size_t>(resident) * emu().systemConfig.mem_per_frame;
 
         list.push_back({
             p.name,
@@ -1170,24 +1626,24 @@ void processSmiGlobal() {
     size_t totalResidentRAM = 0;
     for (auto& p : list) totalResidentRAM += p.ramUsage;
 
-    std::cout << "\n========================== PROCESS-SMI (GLOBAL) ==========================\n";
-    std::cout << "CPU Utilization: " << utilization << "%\n";
-    std::cout << "Total Memory: " << total_mem << " bytes\n";
-    std::cout << "Used Memory:  " << used_mem << " bytes\n";
-    std::cout << "Free Memory:  " << free_mem << " bytes\n";
-    std::cout << "Memory Util:" << (used_mem / total_mem) * 100.f;
-    std::cout << "\n--------------------------------------------------------------------------\n";
-    std::cout << "Total Resident Memory (All Processes): "
+    consoleOut() << "\n========================== PROCESS-SMI (GLOBAL) ==========================\n";
+    consoleOut() << "CPU Utilization: " << utilization << "%\n";
+    consoleOut() << "Total Memory: " << total_mem << " bytes\n";
+    consoleOut() << "Used Memory:  " << used_mem << " bytes\n";
+    consoleOut() << "Free Memory:  " << free_mem << " bytes\n";
+    consoleOut() << "Memory Util:" << (used_mem / total_mem) * 100.f;
+    consoleOut() << "\n--------------------------------------------------------------------------\n";
+    consoleOut() << "Total Resident Memory (All Processes): "
         << totalResidentRAM << " bytes\n";
-    std::cout << "--------------------------------------------------------------------------\n";
+    consoleOut() << "--------------------------------------------------------------------------\n";
 
     if (list.empty()) {
-        std::cout << "No processes found.\n";
-        std::cout << "==================================================================\n\n";
+        consoleOut() << "No processes found.\n";
+        consoleOut() << "==================================================================\n\n";
         return;
     }
 
-    std::cout << std::left
+    consoleOut() << std::left
         << std::setw(12) << "Name"
         << std::setw(7) << "PID"
         << std::setw(12) << "State"
@@ -1198,10 +1654,10 @@ void processSmiGlobal() {
         << std::setw(10) << "RAM Used"
         << "\n";
 
-    std::cout << "---------------------------------------------------------------------------\n";
+    consoleOut() << "---------------------------------------------------------------------------\n";
 
     for (const auto& p : list) {
-        std::cout << std::left
+        consoleOut() << std::left
             << std::setw(12) << p.name
             << std::setw(7) << p.pid
             << std::setw(12) << p.state
@@ -1213,91 +1669,179 @@ void processSmiGlobal() {
             << "\n";
     }
 
-    std::cout << "===========================================================================\n\n";
+    consoleOut() << "===========================================================================\n\n";
 }
 
-// === INPUT LOOP ===
-void inputLoop() {
-    std::string input;
-    while (true) {
-        {
-            std::lock_guard<std::mutex> lock(io_mutex);
-            std::cout << (mode == ConsoleMode::MAIN ? "CSOPESY> " : current_process + "> ") << std::flush;
+// source <file>: runs each non-empty, non-# line as a command in the caller's session
+CommandStatus sourceCommand(Session& session, const std::vector<std::string>& args) {
+    static thread_local int depth = 0;
+    if (args.size() != 2) {
+        consoleOut() << "Usage: source <file>\n";
+        return CommandStatus::OK;
+    }
+    if (depth >= 8) {
+        consoleOut() << "Error: source nested too deeply.\n";
+        return CommandStatus::OK;
+    }
+
+    std::ifstream script(args[1]);
+    if (!script.is_open()) {
+        consoleOut() << "Error: cannot open " << args[1] << "\n";
+        return CommandStatus::OK;
+    }
+
+    depth++;
+    CommandStatus status = CommandStatus::OK;
+    std::string line;
+    while (std::getline(script, line)) {
+        std::string command = trim(line);
+        if (command.empty() || command[0] == '#') continue;
+        consoleOut() << (session.mode == ConsoleMode::MAIN ? "CSOPESY> " : session.current_process + "> ")
+            << command << "\n";
+        if (executeCommand(session, command, consoleOut()) == CommandStatus::EXIT) {
+            status = CommandStatus::EXIT;
+            break;
         }
+    }
+    depth--;
+    return status;
+}
 
-        std::getline(std::cin, input);
-        if (input.empty()) continue;
+// === COMMAND DISPATCH ===
+// Shared by the console, source scripts and the control socket. Callers serialize
+// through commandMutex so commands never interleave, and hold tickMutex so they
+// never overlap a scheduler tick. Everything the command prints goes to out.
+CommandStatus executeCommand(Session& session, const std::string& input, std::ostream& out) {
+    ConsoleOutput output(out);
+    std::vector<std::string> tokens = tokenize(input);
+    if (tokens.empty()) return CommandStatus::OK;
 
-        std::vector<std::string> tokens = tokenize(input);
-        if (tokens.empty()) continue;
-
-        std::string cmd = tokens[0];
-
-        // === MAIN CONSOLE MODE ===
-        if (mode == ConsoleMode::MAIN) {
-            if (cmd == "help") {
-                std::cout << "Available commands:\n"
-                    << "  initialize          - Load configuration and start scheduler\n"
-                    << "  screen              - Create or manage processes\n"
-                    << "  scheduler start     - Begin automatic process creation\n"
-                    << "  scheduler stop      - Stop automatic process creation\n"
-                    << "  report-util         - Generate CPU report\n"
-                    << "  report-trace        - Show execution trace log\n"
-                    << "  exit                - Quit program\n";
-            }
-            else if (cmd == "initialize") initializeCommand();
-            else if (cmd == "screen") handleScreenCommand(tokens);
-            else if (cmd == "scheduler") handleSchedulerCommand(tokens);
-            else if (cmd == "report-util") reportUtilCommand();
-            else if (cmd == "vmstat") vmstatCommand();
-            else if (cmd == "process-smi") processSmiGlobal();
-            else if (cmd == "report-trace") {
-                std::ifstream trace("csopesy-trace.txt");
-                if (!trace.is_open()) {
-                    std::cout << "No trace log found.\n";
-                    continue;
-                }
-                std::cout << "\n=== EXECUTION TRACE ===\n";
-                std::string line;
-                while (std::getline(trace, line)) std::cout << line << "\n";
-                std::cout << "=======================\n";
+    std::string cmd = tokens[0];
+
+    // Scripts and the recorder itself are not replayed; the commands a script runs are
+    if (emu().recorder.active() && cmd != "record" && cmd != "source" && cmd != "control-socket") {
+        emu().recorder.logCommand(emu().global_tick, session.id, input);
+    }
+
+    // === MAIN CONSOLE MODE ===
+    if (session.mode == ConsoleMode::MAIN) {
+        if (cmd == "help") {
+            consoleOut() << "Available commands:\n"
+                << "  initialize          - Load configuration and start scheduler\n"
+                << "  screen              - Create or manage processes\n"
+                << "  load-dir <dir> [mem]- Create a process per program file in a directory\n"
+                << "  scheduler start     - Begin automatic process creation\n"
+                << "  scheduler stop      - Stop automatic process creation\n"
+                << "  report-util         - Generate CPU report\n"
+                << "  report-trace        - Show execution trace log\n"
+                << "  perf-report [reset] - Latency percentiles for ticks, instructions and paging\n"
+                << "  lockstat [reset]    - Contention, wait and hold time per lock\n"
+                << "  optimize <name> [tick-accurate|full] - Optimize the rest of a process's program\n"
+                << "  source <file>       - Run the commands in a script file\n"
+                << "  record <file|stop>  - Record commands for deterministic replay (--replay)\n"
+                << "  checkpoint <file>   - Save the whole emulator state to a snapshot\n"
+                << "  restore <file>      - Load a snapshot and resume from it\n"
+                << "  control-socket <path|stop> - Serve commands over a Unix socket\n"
+                << "  exit                - Quit program\n";
+        }
+        else if (cmd == "initialize") initializeCommand();
+        else if (cmd == "screen") handleScreenCommand(session, tokens);
+        else if (cmd == "load-dir") loadDirCommand(tokens);
+        else if (cmd == "scheduler") handleSchedulerCommand(tokens);
+        else if (cmd == "report-util") reportUtilCommand();
+        else if (cmd == "vmstat") vmstatCommand();
+        else if (cmd == "process-smi") processSmiGlobal();
+        else if (cmd == "perf-report") perfReportCommand(tokens);
+        else if (cmd == "lockstat") lockStatCommand(tokens);
+        else if (cmd == "optimize") optimizeCommand(tokens);
+        else if (cmd == "source") return sourceCommand(session, tokens);
+        else if (cmd == "record") recordCommand(tokens);
+        else if (cmd == "checkpoint") checkpointCommand(tokens);
+        else if (cmd == "restore") restoreCommand(tokens);
+        else if (cmd == "control-socket") controlSocketCommand(tokens);
+        else if (cmd == "report-trace") {
+            std::ifstream trace("csopesy-trace.txt");
+            if (!trace.is_open()) {
+                consoleOut() << "No trace log found.\n";
+                return CommandStatus::OK;
             }
-            else if (cmd == "exit") break;
-            else std::cout << "Unknown command. Type 'help'.\n";
+            consoleOut() << "\n=== EXECUTION TRACE ===\n";
+            std::string line;
+            while (std::getline(trace, line)) consoleOut() << line << "\n";
+            consoleOut() << "=======================\n";
+        }
+        else if (cmd == "exit") return CommandStatus::EXIT;
+        else {
+            consoleOut() << "Unknown command. Type 'help'.\n";
+            return CommandStatus::UNKNOWN;
         }
+    }
 
-        // === PROCESS MODE ===
-        else if (mode == ConsoleMode::PROCESS) {
-            if (cmd == "process-smi") processSmiCommand();
-            else if (cmd == "step") {
-                int pcAfter = 0;
-                std::string procName;
-                bool found = false;
-                {
-                    std::lock_guard<std::mutex> lock(processTableMutex);
-                    Process* p = findProcess(current_process);
-                    if (p) {
-                        found = true;
-                        procName = p->name;
-                        if (p->pc < p->instructions.size()) {
-                            p->instructions[p->pc]->execute(*p);
-                        }
-                        pcAfter = p->pc;
-                    }
-                }
-                if (!found) {
-                    std::cout << "No active process.\n";
-                    continue;
+    // === PROCESS MODE ===
+    else if (session.mode == ConsoleMode::PROCESS) {
+        if (cmd == "process-smi") processSmiCommand(session);
+        else if (cmd == "source") return sourceCommand(session, tokens);
+        else if (cmd == "step") {
+            ProcessHandle h;
+            {
+                std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+                h = findProcess(session.current_process);
+            }
+            // Executed without processTableMutex: instructions take it themselves (via the
+            // memory manager). The caller holds tickMutex, so the scheduler is between ticks.
+            Process* p = emu().processTable.get(h);
+            int pcAfter = 0;
+            std::string procName;
+            bool found = p != nullptr;
+            if (p) {
+                procName = p->name;
+                if (p->pc < p->program->size()) {
+                    ProgramRef program = p->program; // a FOR moves p to another image
+                    (*program)[p->pc]->execute(*p);
                 }
-                std::cout << "Executed instruction " << pcAfter
-                    << " for process " << procName << ".\n";
+                pcAfter = p->pc;
             }
-            else if (cmd == "exit") {
-                std::cout << "Exiting process screen...\n";
-                mode = ConsoleMode::MAIN;
-                current_process.clear();
+            if (!found) {
+                consoleOut() << "No active process.\n";
+                return CommandStatus::OK;
             }
-            else std::cout << "Invalid command in process screen.\n";
+            consoleOut() << "Executed instruction " << pcAfter
+                << " for process " << procName << ".\n";
+        }
+        else if (cmd == "exit") {
+            consoleOut() << "Exiting process screen...\n";
+            session.mode = ConsoleMode::MAIN;
+            session.current_process.clear();
+        }
+        else {
+            consoleOut() << "Invalid command in process screen.\n";
+            return CommandStatus::UNKNOWN;
+        }
+    }
+    return CommandStatus::OK;
+}
+
+// === INPUT LOOP ===
+void inputLoop() {
+    Session session;
+    std::string input;
+    while (true) {
+        {
+            std::lock_guard<InstrumentedMutex> lock(io_mutex);
+            std::cout << (session.mode == ConsoleMode::MAIN ? "CSOPESY> " : session.current_process + "> ") << std::flush;
+        }
+
+        if (!std::getline(std::cin, input)) break; // EOF on piped input
+        if (input.empty()) continue;
+
+        {
+            std::lock_guard<InstrumentedMutex> lock(commandMutex);
+            std::lock_guard<InstrumentedMutex> tickLock(emu().tickMutex);
+            if (executeCommand(session, input, std::cout) == CommandStatus::EXIT) break;
         }
+        controlServer.reap(); // a stopped server's threads may have waited on commandMutex
     }
+    controlServer.stop();
+    controlServer.reap();
+    emu().shutdown(); // before static destruction tears down what the scheduler thread uses
 }
@@ -6,12 +6,24 @@
 #include <deque>
 #include <memory>
 #include <iostream>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
 
 #include "MemoryManager.h"
+#include "ProcessHandle.h"
+#include "Instruction.h"
+#include "ProgramImage.h"
+#include "Symbols.h"
+#include "LockStats.h"
+#include "Random.h"
 
 // === Enums ===
 enum class ConsoleMode { MAIN, PROCESS };
-enum class ProcessState { READY, RUNNING, SLEEPING, FINISHED, MEMORY_VIOLATED };
+enum class CommandStatus { OK, UNKNOWN, EXIT };
+enum class ProcessState : uint8_t { READY, RUNNING, SLEEPING, FINISHED, MEMORY_VIOLATED };
 
 // === Config structure ===
 struct Config {
@@ -22,18 +34,53 @@ struct Config {
     int min_ins = 0;
     int max_ins = 0;
     int delays_per_exec = 0;
+    // "tick": one instruction per core per tick. "quantum": each core runs up to a
+    // quantum per scheduler round and the clock advances by the longest slice.
+    std::string exec_mode = "tick";
+    // Optimizer pass over new programs: "off", "tick-accurate" or "full" (see Optimizer.h)
+    std::string optimize = "off";
     
     // Memory Config
     size_t max_overall_mem = 0;
     size_t mem_per_frame = 0;
     size_t min_mem_per_proc = 0;
     size_t max_mem_per_proc = 0;
+    // Core ticks per page a MEMSET/MEMCPY touches; the instruction's own tick counts toward them
+    int bulk_page_ticks = 1;
+
+    // Metrics export: sample every metrics_interval ticks (0 = off)
+    unsigned long long metrics_interval = 0;
+    std::string metrics_csv;
+    std::string metrics_prom;
+
+    // Workload profile file and the profile used for generated processes
+    std::string workload_file;
+    std::string workload_profile = "default";
+
+    // Directory of compiled program files (see ProgramCache.h); empty = no cache
+    std::string program_cache;
+
+    // Workload seed (config "seed" or --seed); drawn at random when unset
+    unsigned long long seed = 0;
+    bool has_seed = false;
 
     bool loaded = false;
 };
 
+// "key value" settings applied on top of a config file (e.g. by sweeps)
+using ConfigOverrides = std::vector<std::pair<std::string, std::string>>;
+
+// === Console session ===
+// One per interactive console, control-socket connection or script run
+struct Session {
+    int id = 0;           // tags recorded commands (0 = interactive console)
+    ConsoleMode mode = ConsoleMode::MAIN;
+    std::string current_process;
+};
+
 // === Forward declarations ===
 class Process;
+class ProcessTable;
 
 // === Instruction Interface ===
 class Instruction;
@@ -43,15 +90,15 @@ class Process {
 public:
     std::string name;
     int pid;
-    ProcessState state;
-    std::vector<std::shared_ptr<Instruction>> instructions;
+    ProgramRef program = ProgramImage::none(); // shared with every process running the same code
     int pc = 0;
-    std::vector<std::string> logs;
-    std::unordered_map<std::string, int> symbol_table;
-    int symbol_cursor = 0;
-    int sleep_counter = 0;
+    std::pmr::vector<std::pmr::string> logs; // from the same resource as page_table
+    SymbolTable symbol_table; // variables in Page 0, see Symbols.h
     int quantum_used = 0;
     bool needs_cpu = true;
+    int busy_ticks = 0; // core ticks the last MEMSET/MEMCPY still owes; the process holds its core
+    unsigned long long arrival_tick = 0; // global_tick when added to the table
+    unsigned long long finish_tick = 0;  // global_tick when it finished
 
     // Symbol Table Management
     // Max 64 bytes for symbol table. Each uint16 var is 2 bytes.
@@ -61,55 +108,294 @@ public:
     static constexpr size_t MAX_VARIABLES = MAX_SYMBOL_TABLE_SIZE / VAR_SIZE;
     static constexpr size_t SYMBOL_TABLE_SIZE = 64; 
     static constexpr int SYMBOL_TABLE_PAGE = 0; // Symbol table always lives in Page 0
+    static_assert(MAX_VARIABLES == SymbolTable::CAPACITY, "symbol table slots must match the page-0 layout");
 
     
     // Memory Management
     int memory_required = 0; // Total memory required in bytes
-    std::unordered_map<int, PageTableEntry> page_table; // page_num -> entry
+    std::pmr::unordered_map<int, PageTableEntry> page_table; // page_num -> entry
+
+    // Scheduler-scanned fields; stored in the owning ProcessTable's arrays once admitted
+    ProcessState state() const;
+    void setState(ProcessState s);
+    int sleepCounter() const;
+    void setSleepCounter(int ticks);
+    size_t slot() const { return hot.slot; } // index in the owning table
+    size_t instructionCount() const { return program->size(); }
+
+    // Containers allocate from resource; build processes bound for a table with its
+    // resource() so admission moves their storage in instead of copying it
+    explicit Process(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : pid(-1), logs(resource), page_table(resource) {}
 
-    Process() : pid(-1), state(ProcessState::READY) {}
+private:
+    friend class ProcessTable;
+
+    // Where the hot fields live: local values until admitted, then a table slot.
+    // Copies always come out detached, carrying the values current at copy time.
+    struct HotLink {
+        ProcessTable* table = nullptr;
+        size_t slot = 0;
+        ProcessState state = ProcessState::READY;
+        int sleep_counter = 0;
+
+        HotLink() = default;
+        HotLink(const HotLink& other);
+        HotLink& operator=(const HotLink& other);
+    } hot;
+};
+
+// === Process table ===
+// A slot map. Process records live in a deque, so a live record never moves; retired
+// slots go on a free list and are reused with a bumped generation, so holders keep
+// ProcessHandles rather than pointers. Page tables and logs come from the table's
+// pool; a retired process hands its page-table blocks back there for the next one,
+// and its logs move as they are into its FinishedProcess record. The fields every
+// tick scans (state, sleep counter) live in dense arrays indexed by slot, so the
+// scheduler's scans stream through a few bytes per process instead of touching each
+// Process.
+// Retired slots read as FINISHED there, so no scan ever picks them. The scheduler
+// retires each process as it ends (see retireProcess), so the table only holds work.
+class ProcessTable {
+    template <typename TableT, typename ProcessT>
+    class LiveIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Process;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ProcessT*;
+        using reference = ProcessT&;
+
+        LiveIterator(TableT* table, size_t slot) : table(table), slot(slot) { skipRetired(); }
+        reference operator*() const { return table->records[slot]; }
+        pointer operator->() const { return &table->records[slot]; }
+        LiveIterator& operator++() { ++slot; skipRetired(); return *this; }
+        LiveIterator operator++(int) { LiveIterator before = *this; ++*this; return before; }
+        bool operator==(const LiveIterator& other) const { return slot == other.slot; }
+
+    private:
+        void skipRetired() { while (slot < table->live.size() && !table->live[slot]) ++slot; }
+        TableT* table;
+        size_t slot;
+    };
+
+public:
+    using iterator = LiveIterator<ProcessTable, Process>;
+    using const_iterator = LiveIterator<const ProcessTable, const Process>;
+
+    ProcessTable() = default;
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    // Stores p in a free slot (or a new one) and moves its hot fields into the arrays
+    ProcessHandle insert(Process p);
+    // Retires the process; false if the handle was already stale
+    bool erase(ProcessHandle h);
+    void clear(); // drops every process; slot generations survive, so no old handle resolves again
+
+    // Pool for the per-process containers; thread-safe, so the generator can build with it
+    std::pmr::memory_resource* resource() { return &pool; }
+
+    // nullptr once the process has been retired
+    Process* get(ProcessHandle h);
+    const Process* get(ProcessHandle h) const;
+    ProcessHandle handleAt(size_t slot) const;
+    ProcessHandle find(int pid) const;
+
+    size_t size() const { return liveCount; }          // live processes
+    bool empty() const { return liveCount == 0; }
+    size_t slotCount() const { return records.size(); } // live and retired slots
+    Process& operator[](size_t slot) { return records[slot]; }
+    const Process& operator[](size_t slot) const { return records[slot]; }
+
+    // Live processes in slot order
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, records.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, records.size()); }
+
+    // Hot fields, indexed by slot
+    std::vector<ProcessState> states;
+    std::vector<int> sleepCounters;
+
+    // Scans over the hot arrays
+    bool anyActive() const;     // any READY, RUNNING or SLEEPING
+    bool anyReadyExcept(size_t slot) const;
+    size_t nextReady(size_t from, bool wrap) const; // first READY slot at/after from, slotCount() if none
+    void countStates(size_t counts[5]) const;        // live processes, indexed by ProcessState
+    void wakeSleepers(int ticks = 1); // ticks of sleep countdown
+
+private:
+    std::pmr::synchronized_pool_resource pool; // declared first: outlives every record
+    std::deque<Process> records;
+    std::vector<uint32_t> generations;
+    std::vector<uint8_t> live;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<int, uint32_t> pidIndex;
+    size_t liveCount = 0;
+};
+
+inline Process::HotLink::HotLink(const HotLink& other)
+    : state(other.table ? other.table->states[other.slot] : other.state),
+      sleep_counter(other.table ? other.table->sleepCounters[other.slot] : other.sleep_counter) {}
+
+inline Process::HotLink& Process::HotLink::operator=(const HotLink& other) {
+    if (this != &other) {
+        ProcessState s = other.table ? other.table->states[other.slot] : other.state;
+        int sleep = other.table ? other.table->sleepCounters[other.slot] : other.sleep_counter;
+        if (table) {
+            table->states[slot] = s;
+            table->sleepCounters[slot] = sleep;
+        }
+        else {
+            state = s;
+            sleep_counter = sleep;
+        }
+    }
+    return *this;
+}
+
+inline ProcessState Process::state() const { return hot.table ? hot.table->states[hot.slot] : hot.state; }
+inline int Process::sleepCounter() const { return hot.table ? hot.table->sleepCounters[hot.slot] : hot.sleep_counter; }
+
+inline void Process::setState(ProcessState s) {
+    if (hot.table) hot.table->states[hot.slot] = s;
+    else hot.state = s;
+}
+
+inline void Process::setSleepCounter(int ticks) {
+    if (hot.table) hot.table->sleepCounters[hot.slot] = ticks;
+    else hot.sleep_counter = ticks;
+}
+
+// === Finished processes ===
+// What is left of a process once it ends: enough for screen -ls, process-smi, reports
+// and digests, without the program image, page table or scheduling fields. Its logs
+// stay on the allocator they were written with, so retiring moves them in as they are.
+struct FinishedProcess {
+    std::string name;
+    int pid = -1;
+    ProcessState end_state = ProcessState::FINISHED;
+    int pc = 0;
+    size_t instruction_count = 0;
+    int sleep_counter = 0;
+    int busy_ticks = 0;
+    unsigned long long arrival_tick = 0;
+    unsigned long long finish_tick = 0;
+    int memory_required = 0;
+    SymbolTable symbol_table;
+    std::pmr::vector<std::pmr::string> logs;
+
+    explicit FinishedProcess(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : logs(resource) {}
+    // Takes the name and logs from p; the rest of p is left for its table to reclaim
+    explicit FinishedProcess(Process&& p)
+        : name(std::move(p.name)), pid(p.pid), end_state(p.state()), pc(p.pc),
+          instruction_count(p.instructionCount()), sleep_counter(p.sleepCounter()),
+          busy_ticks(p.busy_ticks), arrival_tick(p.arrival_tick), finish_tick(p.finish_tick),
+          memory_required(p.memory_required), symbol_table(p.symbol_table), logs(std::move(p.logs)) {}
+
+    // Same accessors as Process, so code walking both kinds reads them alike
+    ProcessState state() const { return end_state; }
+    int sleepCounter() const { return sleep_counter; }
+    size_t instructionCount() const { return instruction_count; }
+};
+
+// Processes retired from the table, in the order they ended. Counts by end state are
+// kept as records arrive, so a sampler never rescans a list that grows with every
+// process ever run. Guarded by processTableMutex, like the table.
+class FinishedProcesses {
+public:
+    using const_iterator = std::deque<FinishedProcess>::const_iterator;
+
+    void push_back(FinishedProcess p) {
+        (p.state() == ProcessState::FINISHED ? finished : violated)++;
+        records.push_back(std::move(p));
+    }
+    void clear() {
+        records.clear();
+        finished = violated = 0;
+    }
+
+    size_t size() const { return records.size(); }
+    bool empty() const { return records.empty(); }
+    const FinishedProcess& back() const { return records.back(); }
+    const_iterator begin() const { return records.begin(); }
+    const_iterator end() const { return records.end(); }
+
+    size_t finishedCount() const { return finished; } // ended normally
+    size_t violatedCount() const { return violated; } // ended on a memory violation
+
+private:
+    std::deque<FinishedProcess> records;
+    size_t finished = 0;
+    size_t violated = 0;
 };
 
 // === CPUCore Class ===
 class CPUCore {
 public:
     int id;
-    Process* running = nullptr;
+    ProcessHandle running; // empty when idle
     int quantum_left = 0;
 
     CPUCore() : id(-1) {}
 };
 
 // === Shared globals ===
-extern std::mutex io_mutex;
-extern std::mutex processTableMutex;
-extern bool initialized;
-extern Config systemConfig;
-extern ConsoleMode mode;
-extern std::deque<Process> processTable;
-extern std::vector<CPUCore> cpuCores;
-extern int nextPID;
-extern std::string current_process;
-extern unsigned long long global_tick;
-extern size_t rrCursor;
-
-// Memory Manager Global
-extern std::unique_ptr<MemoryManager> memoryManager;
+// Console-wide locks; per-simulation state lives in Emulator (Emulator.h)
+extern InstrumentedMutex io_mutex;
+extern InstrumentedMutex commandMutex;   // serializes command execution across sessions
+
+// === Console output ===
+// Where commands and the emulator print on the calling thread: std::cout unless a
+// ConsoleOutput scope on that thread points it elsewhere (a control-socket reply,
+// stderr in headless mode). Unlike swapping std::cout's buffer, a scope never
+// redirects what other threads print, such as the scheduler's messages.
+std::ostream& consoleOut();
+
+class ConsoleOutput {
+public:
+    explicit ConsoleOutput(std::ostream& to);
+    ~ConsoleOutput();
+    ConsoleOutput(const ConsoleOutput&) = delete;
+    ConsoleOutput& operator=(const ConsoleOutput&) = delete;
+
+private:
+    std::ostream* previous;
+};
 
 
 // === Function declarations ===
 void inputLoop();
+bool initializeSystem(const std::string& configFile, const ConfigOverrides& overrides = {});
 void initializeCommand();
-void handleScreenCommand(const std::vector<std::string>& args);
+CommandStatus executeCommand(Session& session, const std::string& input, std::ostream& out); // prints to out
+CommandStatus sourceCommand(Session& session, const std::vector<std::string>& args);
+void controlSocketCommand(const std::vector<std::string>& args);
+void perfReportCommand(const std::vector<std::string>& args);
+void lockStatCommand(const std::vector<std::string>& args);
+void optimizeCommand(const std::vector<std::string>& args);
+void handleScreenCommand(Session& session, const std::vector<std::string>& args);
+void loadDirCommand(const std::vector<std::string>& args);
 void schedulerStartCommand();
 void schedulerStopCommand();
 void reportUtilCommand();
-void processSmiCommand();
-bool loadConfigFile(const std::string& filename);
+void processSmiCommand(const Session& session);
+bool loadConfigFile(const std::string& filename, const ConfigOverrides& overrides = {});
+ConfigOverrides configToSettings(const Config& config); // the config as "key value" settings
 bool generateDefaultConfig(const std::string& filename);
-// Changed to return shared_ptr<Instruction>
-std::vector<std::shared_ptr<Instruction>> generateDummyInstructions(int count, int memSize);
-Process* findProcess(const std::string& name);
+void generateDummyInstructions(InstructionList& out, int count, int memSize, Rng& rng); // appends
+ProgramRef prepareProgram(InstructionList ins); // applies the configured optimizer, then interns
+ProcessHandle findProcess(const std::string& name); // live processes only
+const FinishedProcess* findFinishedProcess(const std::string& name);
+bool processNameTaken(const std::string& name);     // live or finished
+void retireProcess(ProcessHandle h);
+void admitGeneratedProcess(Process&& newProc);
+int createProcess(const std::string& name, int memory, std::vector<std::shared_ptr<Instruction>> instructions);
+void scheduler_loop_tick(bool hasActiveWork);
+void logInstructionTrace(Process& p, const Instruction& instr, unsigned long long tick); // no-op unless tracing
+void ensureSchedulerActive();
 std::vector<std::string> tokenize(const std::string& input);
 
 // Helper to parse string to instruction
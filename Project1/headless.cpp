@@ -0,0 +1,266 @@
+#include "headless.h"
+#include "Emulator.h"
+#include "ProcessGenerator.h"
+#include "Sweep.h"
+#include "Replay.h"
+#include "Snapshot.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// Peak resident set size of this process in KB
+static size_t peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<size_t>(pmc.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss / 1024); // bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss);        // already KB on Linux
+#endif
+#endif
+}
+
+void printHeadlessUsage() {
+    std::cerr << "Usage: csopesy [--config <file>] [--ticks N | --until-idle] [--processes N]\n"
+        << "               [--auto-create] [--seed S] [--no-trace]\n"
+        << "               [--sweep key=values ...] [--jobs N] [--sweep-csv <file>]\n"
+        << "       csopesy --replay <recording>\n"
+        << "       csopesy --restore <snapshot> [headless options]\n"
+        << "Runs the scheduler headless and prints a JSON summary to stdout.\n"
+        << "With --sweep, runs every combination of the given config values in parallel\n"
+        << "and prints a comparison table. values: a,b,c | lo..hi | lo..hi+step | lo..hi*factor\n"
+        << "--replay re-runs a 'record' session unthrottled and checks the final state digest.\n"
+        << "--restore resumes a checkpoint; on its own it opens the interactive console.\n";
+}
+
+bool parseHeadlessArgs(int argc, char* argv[], HeadlessOptions& opts, std::string& error) {
+    if (argc <= 1) return false;
+
+    auto numberArg = [&](int& i, const std::string& flag, unsigned long long& out) {
+        if (i + 1 >= argc) {
+            error = flag + " requires a value";
+            return false;
+        }
+        try {
+            size_t used = 0;
+            std::string text = argv[++i];
+            out = std::stoull(text, &used);
+            if (used != text.size()) throw std::invalid_argument(text);
+        }
+        catch (...) {
+            error = "Invalid value for " + flag + ": " + argv[i];
+            return false;
+        }
+        return true;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        unsigned long long value = 0;
+
+        if (arg == "--config") {
+            if (i + 1 >= argc) {
+                error = "--config requires a file";
+                return true;
+            }
+            opts.configFile = argv[++i];
+        }
+        else if (arg == "--ticks") {
+            if (!numberArg(i, arg, value)) return true;
+            if (value == 0) {
+                error = "--ticks must be positive";
+                return true;
+            }
+            opts.ticks = value;
+            opts.untilIdle = false;
+        }
+        else if (arg == "--until-idle") {
+            opts.ticks = 0;
+            opts.untilIdle = true;
+        }
+        else if (arg == "--processes") {
+            if (!numberArg(i, arg, value)) return true;
+            opts.processes = static_cast<int>(value);
+        }
+        else if (arg == "--auto-create") opts.autoCreate = true;
+        else if (arg == "--seed") {
+            if (!numberArg(i, arg, value)) return true;
+            opts.seeded = true;
+            opts.seed = value;
+        }
+        else if (arg == "--no-trace") opts.trace = false;
+        else if (arg == "--sweep") {
+            if (i + 1 >= argc) {
+                error = "--sweep requires key=values";
+                return true;
+            }
+            SweepAxis axis;
+            if (!parseSweepAxis(argv[++i], axis, error)) return true;
+            opts.sweep.push_back(std::move(axis));
+        }
+        else if (arg == "--jobs") {
+            if (!numberArg(i, arg, value)) return true;
+            opts.jobs = static_cast<int>(value);
+        }
+        else if (arg == "--restore") {
+            if (i + 1 >= argc) {
+                error = "--restore requires a snapshot";
+                return true;
+            }
+            opts.restoreFile = argv[++i];
+        }
+        else if (arg == "--replay") {
+            if (i + 1 >= argc) {
+                error = "--replay requires a recording";
+                return true;
+            }
+            opts.replayFile = argv[++i];
+        }
+        else if (arg == "--sweep-csv") {
+            if (i + 1 >= argc) {
+                error = "--sweep-csv requires a file";
+                return true;
+            }
+            opts.sweepCsv = argv[++i];
+        }
+        else {
+            error = "Unknown argument: " + arg;
+            return true;
+        }
+    }
+
+    if (opts.autoCreate && opts.untilIdle) {
+        error = "--auto-create never goes idle; use --ticks N";
+    }
+    return true;
+}
+
+static bool hasActiveProcesses() {
+    std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+    return emu().processTable.anyActive();
+}
+
+bool runSimulation(const HeadlessOptions& opts, const ConfigOverrides& overrides, RunSummary& out) {
+    emu().traceEnabled = opts.trace;
+    emu().throttleTicks = false;
+
+    if (!opts.restoreFile.empty()) {
+        std::string error;
+        if (!loadSnapshot(opts.restoreFile, error)) {
+            consoleOut() << "Error: " << error << "\n";
+            return false;
+        }
+    }
+    else if (!initializeSystem(opts.configFile, overrides)) {
+        return false;
+    }
+    if (opts.seeded) emu().systemConfig.seed = opts.seed;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    emu().processGenerator.start();
+    for (int i = 0; i < opts.processes; ++i) {
+        Process newProc(emu().processTable.resource());
+        if (emu().processGenerator.pop(newProc, true)) admitGeneratedProcess(std::move(newProc));
+    }
+    if (!opts.autoCreate) emu().processGenerator.stop();
+    emu().autoCreateRunning.store(opts.autoCreate);
+
+    const unsigned long long startTick = emu().global_tick;
+    const unsigned long long startInstructions = emu().instructionsExecuted;
+    const unsigned long long startBusy = emu().busyCoreTicks;
+    while (true) {
+        if (opts.untilIdle) {
+            if (!hasActiveProcesses()) break;
+        }
+        else if (emu().global_tick - startTick >= opts.ticks) {
+            break;
+        }
+        scheduler_loop_tick(true);
+    }
+    emu().autoCreateRunning.store(false);
+    emu().processGenerator.stop();
+
+    const auto end = std::chrono::steady_clock::now();
+
+    out = RunSummary{};
+    out.seed = emu().systemConfig.seed;
+    out.wallSeconds = std::chrono::duration<double>(end - start).count();
+    out.ticks = emu().global_tick - startTick;
+    out.instructions = emu().instructionsExecuted - startInstructions;
+    VMStatCounters vm = emu().memoryManager->getVMStat();
+    out.pageFaults = vm.pages_paged_in;
+    out.pagedOut = vm.pages_paged_out;
+
+    unsigned long long turnaround = 0;
+    {
+        std::lock_guard<InstrumentedMutex> lock(emu().processTableMutex);
+        out.processes = emu().processTable.size() + emu().finishedProcesses.size();
+        emu().forEachProcess([&](const auto& p) {
+            if (p.state() == ProcessState::FINISHED) {
+                out.finished++;
+                turnaround += p.finish_tick - p.arrival_tick;
+            }
+            else if (p.state() == ProcessState::MEMORY_VIOLATED) out.violated++;
+        });
+    }
+    if (out.finished > 0) out.meanTurnaround = static_cast<double>(turnaround) / out.finished;
+    size_t cores = emu().cpuCores.size();
+    if (out.ticks > 0 && cores > 0) out.utilization = static_cast<double>(emu().busyCoreTicks - startBusy) / (static_cast<double>(cores) * out.ticks);
+    return true;
+}
+
+int runHeadless(const HeadlessOptions& opts) {
+    if (!opts.replayFile.empty()) return runReplay(opts.replayFile);
+    if (!opts.sweep.empty()) return runSweep(opts);
+
+    RunSummary run;
+    bool ok = false;
+    {
+        // Keep stdout clean for the summary; everything else the emulator prints goes to stderr
+        ConsoleOutput toStderr(std::cerr);
+        ok = runSimulation(opts, {}, run);
+    }
+    if (!ok) {
+        std::cerr << "Error: could not load " << (opts.restoreFile.empty() ? opts.configFile : opts.restoreFile) << "\n";
+        return 1;
+    }
+
+    double wall = run.wallSeconds;
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3)
+        << "{\"seed\":" << run.seed
+        << ",\"ticks\":" << run.ticks
+        << ",\"instructions\":" << run.instructions
+        << ",\"processes\":" << run.processes
+        << ",\"finished\":" << run.finished
+        << ",\"memory_violations\":" << run.violated
+        << ",\"page_faults\":" << run.pageFaults
+        << ",\"pages_paged_out\":" << run.pagedOut
+        << ",\"mean_turnaround_ticks\":" << run.meanTurnaround
+        << ",\"cpu_utilization\":" << run.utilization
+        << ",\"wall_time_s\":" << wall
+        << ",\"ticks_per_s\":" << (wall > 0 ? run.ticks / wall : 0.0)
+        << ",\"instructions_per_s\":" << (wall > 0 ? run.instructions / wall : 0.0)
+        << ",\"peak_rss_kb\":" << peakRssKb()
+        << "}";
+    std::cout << json.str() << std::endl;
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "globals.h"
+
+// === Headless batch/benchmark mode ===
+// Runs the scheduler on the calling thread without the interactive console and
+// prints a one-line JSON summary to stdout. Console chatter goes to stderr.
+struct SweepAxis {
+    std::string key;                  // config key, e.g. "quantum-cycles"
+    std::vector<std::string> values;
+};
+
+struct HeadlessOptions {
+    std::string configFile = "config.txt";
+    unsigned long long ticks = 0;   // 0 = run until idle
+    bool untilIdle = true;
+    int processes = 0;              // processes created before the first tick
+    bool autoCreate = false;        // keep the batch auto-creator on while ticking
+    bool seeded = false;
+    unsigned long long seed = 0;    // overrides the config seed
+    bool trace = true;
+
+    // Parameter sweep: run every combination of these config values (see Sweep.h)
+    std::vector<SweepAxis> sweep;
+    int jobs = 0;                   // concurrent runs (0 = one per host core)
+    std::string sweepCsv;           // optional CSV copy of the sweep table
+
+    std::string replayFile;         // replay a recording instead (see Replay.h)
+    std::string restoreFile;        // start from a checkpoint instead of the config (see Snapshot.h)
+};
+
+// Outcome of one run, shared by the JSON summary and the sweep table
+struct RunSummary {
+    unsigned long long seed = 0;
+    unsigned long long ticks = 0;
+    unsigned long long instructions = 0;
+    size_t processes = 0, finished = 0, violated = 0;
+    unsigned long long pageFaults = 0, pagedOut = 0;
+    double wallSeconds = 0.0;
+    double meanTurnaround = 0.0;    // ticks from arrival to finish, over finished processes
+    double utilization = 0.0;       // busy core-ticks / (cores * ticks)
+};
+
+// Returns true if argv asked for headless mode; sets error on malformed arguments
+bool parseHeadlessArgs(int argc, char* argv[], HeadlessOptions& opts, std::string& error);
+void printHeadlessUsage();
+int runHeadless(const HeadlessOptions& opts);
+
+// Initializes and runs the instance bound to this thread (see Emulator.h); false if the config fails to load
+bool runSimulation(const HeadlessOptions& opts, const ConfigOverrides& overrides, RunSummary& out);
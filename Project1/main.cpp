@@ -1,14 +1,29 @@
 #include "globals.h"
+#include "headless.h"
+#include "Snapshot.h"
 #include <iostream>
-#include <ctime>
-#include <cstdlib>
 
-int main() {
-    srand(static_cast<unsigned int>(time(0)));
+int main(int argc, char* argv[]) {
+    HeadlessOptions opts;
+    std::string argError;
+    if (parseHeadlessArgs(argc, argv, opts, argError)) {
+        if (!argError.empty()) {
+            std::cerr << "Error: " << argError << "\n";
+            printHeadlessUsage();
+            return 2;
+        }
+        // --restore on its own resumes the snapshot in the interactive console
+        if (argc != 3 || opts.restoreFile.empty()) return runHeadless(opts);
+    }
+
     std::cout << "Welcome to CSOPESY Emulator CLI\n";
     std::cout << "Developers: Go, Michael Joseph | Go, Michael Anthony | Magaling, Zoe | Uy, Matthew\n";
     std::cout << "Version date: 11/5/25\n\n";
 
+    if (!opts.restoreFile.empty()) {
+        std::vector<std::string> restoreArgs = { "restore", opts.restoreFile };
+        restoreCommand(restoreArgs);
+    }
     inputLoop();
     std::cout << "Exiting CSOPESY Emulator...\n";
 }
@@ -0,0 +1,273 @@
+// Microbenchmarks for the emulator's hot paths.
+// Usage: csopesy_bench [name-filter]
+// Prints ns/op and heap allocations/op for each benchmark.
+#include "Emulator.h"
+#include "Instruction.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <ostream>
+
+// === Allocation counting ===
+static std::atomic<unsigned long long> allocCount{ 0 };
+
+void* operator new(std::size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// === Harness ===
+static std::string filter;
+static std::ostream* report = &std::cout;
+
+// Runs fn `iterations` times (after a short warm-up) and prints ns/op and allocs/op
+static void bench(const std::string& name, long iterations, const std::function<void()>& fn) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+    for (long i = 0; i < iterations / 10 + 1; ++i) fn();
+
+    unsigned long long allocsBefore = allocCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) fn();
+    auto end = std::chrono::steady_clock::now();
+    unsigned long long allocs = allocCount.load() - allocsBefore;
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    *report << std::left << std::setw(50) << name
+        << std::right << std::setw(10) << iterations
+        << std::setw(14) << std::fixed << std::setprecision(1) << ns
+        << std::setw(12) << std::setprecision(2) << static_cast<double>(allocs) / iterations
+        << "\n";
+}
+
+// Resets all emulator globals to a fresh system with the given geometry
+static void resetEmulator(size_t frames, size_t frameSize, int cores) {
+    emu().processTable.clear();
+    emu().finishedProcesses.clear();
+    emu().systemConfig = Config();
+    emu().systemConfig.num_cpu = cores;
+    emu().systemConfig.scheduler = "rr";
+    emu().systemConfig.quantum_cycles = 5;
+    emu().systemConfig.batch_process_freq = 1;
+    emu().systemConfig.min_ins = 100;
+    emu().systemConfig.max_ins = 100;
+    emu().systemConfig.max_overall_mem = frames * frameSize;
+    emu().systemConfig.mem_per_frame = frameSize;
+    emu().systemConfig.min_mem_per_proc = 4096;
+    emu().systemConfig.max_mem_per_proc = 4096;
+    emu().systemConfig.loaded = true;
+
+    emu().cpuCores.assign(cores, CPUCore());
+    for (int i = 0; i < cores; ++i) emu().cpuCores[i].id = i;
+
+    emu().memoryManager = std::make_unique<MemoryManager>(frames, frameSize);
+    emu().global_tick = 0;
+    emu().rrCursor = 0;
+    emu().nextPID = 1;
+    emu().initialized = true;
+    emu().traceEnabled = false;
+    emu().throttleTicks = false;
+    emu().autoCreateRunning.store(false);
+}
+
+// Adds a READY process with the given program and returns it
+static Process& addProcess(ProgramRef program, int memory) {
+    Process p(emu().processTable.resource());
+    p.pid = emu().nextPID++;
+    p.name = "bench_p" + std::to_string(p.pid);
+    p.setState(ProcessState::READY);
+    p.program = std::move(program);
+    p.memory_required = memory;
+    emu().memoryManager->initializePageTable(p, static_cast<int>((memory + emu().systemConfig.mem_per_frame - 1) / emu().systemConfig.mem_per_frame));
+    return *emu().processTable.get(emu().processTable.insert(p));
+}
+
+static void benchParser() {
+    const char* samples[] = {
+        "DECLARE(x, 5)",
+        "ADD(sum, x, y)",
+        "PRINT('Value of sum: ' + sum)",
+        "FOR([PRINT('Hello world!')], 2)",
+        "READ(val, 1234)",
+        "WRITE(0x40, 42)",
+        "SLEEP 3",
+    };
+    for (const char* s : samples) {
+        std::string line = s;
+        bench("parseInstruction/" + line, 20000, [&]() {
+            auto inst = parseInstruction(line);
+            if (!inst) std::abort();
+        });
+    }
+
+    Rng rng(1);
+    for (int count : { 10, 100, 1000 }) {
+        bench("generateDummyInstructions/" + std::to_string(count), 20000 / count + 1, [&]() {
+            InstructionList ins;
+            generateDummyInstructions(ins, count, 4096, rng);
+            if (ins.empty()) std::abort();
+        });
+    }
+}
+
+static void benchExecute() {
+    const char* samples[] = {
+        "DECLARE(x, 5)",
+        "ADD(sum, x, y)",
+        "SUBTRACT(diff, y, x)",
+        "PRINT('Hello world!')",
+        "PRINT('Value of sum: ' + sum)",
+        "SLEEP(2)",
+        "FOR([PRINT('Hello world!')], 2)",
+        "WRITE(64, 42)",
+        "READ(val, 64)",
+        "MEMSET(64, 42, 256)",
+        "MEMCPY(1024, 64, 256)",
+    };
+    for (const char* s : samples) {
+        resetEmulator(1024, 16, 1);
+        auto inst = parseInstruction(s);
+        ProgramRef image = ProgramImage::intern({ inst });
+        Process& p = addProcess(image, 4096);
+        p.setState(ProcessState::RUNNING);
+        // Warm the variables and pages used by the samples
+        parseInstruction("DECLARE(x, 5)")->execute(p);
+        parseInstruction("DECLARE(y, 10)")->execute(p);
+
+        bench(std::string("execute/") + s, 50000, [&]() {
+            p.pc = 0;
+            p.setState(ProcessState::RUNNING);
+            if (p.program->size() != 1) p.program = image;
+            inst->execute(p);
+            if (p.logs.size() > 1024) p.logs.clear();
+        });
+    }
+}
+
+static void benchMemory() {
+    // Hit: same resident page every time
+    resetEmulator(256, 16, 1);
+    Process& hitProc = addProcess(ProgramImage::none(), 4096);
+    int value = 7;
+    emu().memoryManager->access(hitProc.pid, 0, true, value);
+    bench("access/hit", 200000, [&]() {
+        int v = 0;
+        emu().memoryManager->access(hitProc.pid, 0, false, v);
+    });
+
+    // Fault with free frames: every access touches a new page, memory manager rebuilt when full
+    resetEmulator(256, 16, 1);
+    int faultPid = addProcess(ProgramImage::none(), 65536).pid;
+    int nextPage = 0;
+    bench("access/fault-free-frame", 20000, [&]() {
+        if (nextPage == 256) {
+            emu().memoryManager = std::make_unique<MemoryManager>(256, 16);
+            nextPage = 0;
+        }
+        int v = 0;
+        emu().memoryManager->access(faultPid, nextPage++ * 16, false, v);
+    });
+
+    // Fault + clean eviction: cycling reads over one page more than fits in RAM
+    for (size_t frames : { 16, 64, 256, 1024 }) {
+        resetEmulator(frames, 16, 1);
+        int pid = addProcess(ProgramImage::none(), static_cast<int>((frames + 1) * 16)).pid;
+        size_t page = 0;
+        bench("access/fault-evict-clean/frames=" + std::to_string(frames), 20000, [&]() {
+            int v = 0;
+            emu().memoryManager->access(pid, static_cast<int>(page * 16), false, v);
+            page = (page + 1) % (frames + 1);
+            emu().global_tick++;
+        });
+    }
+
+    // Fault + dirty eviction: writes force write-back to the backing store
+    for (size_t frames : { 16, 64 }) {
+        resetEmulator(frames, 16, 1);
+        int pid = addProcess(ProgramImage::none(), static_cast<int>((frames + 1) * 16)).pid;
+        size_t page = 0;
+        bench("access/fault-evict-dirty/frames=" + std::to_string(frames), 2000, [&]() {
+            int v = 1;
+            emu().memoryManager->access(pid, static_cast<int>(page * 16), true, v);
+            page = (page + 1) % (frames + 1);
+            emu().global_tick++;
+        });
+    }
+
+    // Bulk: 1 KB over resident pages as one fill/copy, and as the per-word accesses a
+    // READ/WRITE loop would make
+    resetEmulator(1024, 16, 1);
+    int bulkPid = addProcess(ProgramImage::none(), 4096).pid;
+    emu().memoryManager->fill(bulkPid, 0, 4096, 1);
+    bench("bulk/fill-1KB", 200000, [&]() {
+        emu().memoryManager->fill(bulkPid, 2048, 1024, 7);
+    });
+    bench("bulk/copy-1KB", 200000, [&]() {
+        emu().memoryManager->copy(bulkPid, 2048, 0, 1024);
+    });
+    bench("bulk/access-loop-copy-1KB", 2000, [&]() {
+        for (int i = 0; i < 1024; ++i) {
+            int v = 0;
+            emu().memoryManager->access(bulkPid, i, false, v);
+            emu().memoryManager->access(bulkPid, 2048 + i, true, v);
+        }
+    });
+}
+
+static void benchSchedulerTick() {
+    InstructionList program;
+    const char* body[] = { "DECLARE(x, 5)", "DECLARE(y, 10)", "ADD(sum, x, y)", "PRINT('Value of sum: ' + sum)" };
+    for (int i = 0; i < 4000; ++i) program.push_back(parseInstruction(body[i % 4]));
+    ProgramRef image = ProgramImage::intern(std::move(program)); // shared by every process below
+
+    for (int count : { 16, 256, 4096 }) {
+        resetEmulator(1024, 16, 4);
+        for (int i = 0; i < count; ++i) addProcess(image, 4096);
+        bench("scheduler_loop_tick/procs=" + std::to_string(count), 2000, [&]() {
+            scheduler_loop_tick(true);
+        });
+        for (auto& p : emu().processTable) p.logs.clear();
+    }
+
+    // Per executed instruction, one instruction per core per tick vs a quantum per round
+    for (const char* mode : { "tick", "quantum" }) {
+        resetEmulator(1024, 16, 4);
+        emu().systemConfig.exec_mode = mode;
+        for (int i = 0; i < 256; ++i) addProcess(image, 4096);
+        unsigned long long target = emu().instructionsExecuted;
+        bench(std::string("scheduler_instruction/exec-mode=") + mode, 20000, [&]() {
+            ++target;
+            while (emu().instructionsExecuted < target) scheduler_loop_tick(true);
+        });
+        for (auto& p : emu().processTable) p.logs.clear();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) filter = argv[1];
+
+    // Results go to the real stdout; emulator console output is discarded
+    std::ostream out(std::cout.rdbuf());
+    report = &out;
+    std::streambuf* stdoutBuf = std::cout.rdbuf(nullptr);
+
+    out << std::left << std::setw(50) << "benchmark"
+        << std::right << std::setw(10) << "iters"
+        << std::setw(14) << "ns/op"
+        << std::setw(12) << "allocs/op" << "\n";
+
+    benchParser();
+    benchExecute();
+    benchMemory();
+    benchSchedulerTick();
+
+    std::cout.rdbuf(stdoutBuf);
+    return 0;
+}
@@ -0,0 +1,655 @@
+// Regression tests for the emulator core. With no arguments every test runs; with a
+// name only that one does, which is how ctest registers them one by one.
+#include "Emulator.h"
+#include "Instruction.h"
+#include "Optimizer.h"
+#include "ProgramLoader.h"
+#include "Replay.h"
+#include "Snapshot.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <thread>
+
+// === Allocation counting ===
+static std::atomic<unsigned long long> allocCount{ 0 };
+
+void* operator new(std::size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (0)
+
+    // A fresh single-core FCFS instance bound to this thread; the test drives its ticks
+    struct TestSystem {
+        Emulator sim;
+        EmulatorBinding bind{ sim };
+
+        explicit TestSystem(const ConfigOverrides& extra = {}) {
+            sim.externalTicks = true;
+            sim.throttleTicks = false;
+            sim.traceEnabled = false;
+            sim.backingStorePath.clear();
+            ConfigOverrides settings = {
+                { "num-cpu", "1" }, { "scheduler", "fcfs" }, { "seed", "1" },
+                { "max-overall-mem", "256" }, { "mem-per-frame", "16" },
+                { "min-mem-per-proc", "64" }, { "max-mem-per-proc", "64" },
+            };
+            settings.insert(settings.end(), extra.begin(), extra.end());
+            initializeSystem("", settings);
+        }
+
+        int create(const std::string& name, std::initializer_list<const char*> lines) {
+            std::vector<std::shared_ptr<Instruction>> program;
+            for (const char* line : lines) program.push_back(parseInstruction(line));
+            return createProcess(name, 64, std::move(program));
+        }
+
+        void runToCompletion() {
+            while (sim.processTable.anyActive()) scheduler_loop_tick(true);
+        }
+    };
+
+    // === Seeded workloads ===
+    // Generates and runs a batch of processes the way headless mode does; returns the digest
+    uint64_t generatedRunDigest(const char* seed) {
+        TestSystem t({ { "seed", seed }, { "min-ins", "5" }, { "max-ins", "40" } });
+        t.sim.processGenerator.start();
+        for (int i = 0; i < 6; ++i) {
+            Process generated(t.sim.processTable.resource());
+            if (t.sim.processGenerator.pop(generated, true)) admitGeneratedProcess(std::move(generated));
+        }
+        t.sim.processGenerator.stop();
+        t.runToCompletion();
+        return stateDigest(t.sim);
+    }
+
+    // The same seed always builds and runs the same workload; another seed does not
+    void seededRunsRepeat() {
+        const uint64_t first = generatedRunDigest("7");
+        CHECK(generatedRunDigest("7") == first);
+        CHECK(generatedRunDigest("8") != first);
+    }
+
+    // === Program files ===
+    // Statements split on newlines and on ';' outside quotes and FOR bodies; '#' lines are
+    // skipped, and an error names the line it is on
+    void programTextParses() {
+        std::vector<std::shared_ptr<Instruction>> program;
+        std::string error;
+        const char* text =
+            "# setup\n"
+            "DECLARE(x, 1); DECLARE(y, 2)\n"
+            "  # indented comment\n"
+            "PRINT('a;b' + x)\n"
+            "FOR([ADD(x, x, 1); ADD(y, y, x)], 3)\n";
+        CHECK(parseProgramText(text, program, error));
+        CHECK(error.empty());
+        CHECK(program.size() == 4);
+        if (program.size() == 4) {
+            CHECK(program[0]->opcode() == Opcode::DECLARE && program[1]->opcode() == Opcode::DECLARE);
+            CHECK(program[2]->opcode() == Opcode::PRINT);
+            CHECK(program[3]->opcode() == Opcode::FOR);
+            CHECK(static_cast<const ForInstruction&>(*program[3]).loopBody().size() == 2);
+        }
+
+        program.clear();
+        CHECK(!parseProgramText("DECLARE(x, 1)\nJUMP(x)\n", program, error));
+        CHECK(error.find("line 2") != std::string::npos);
+        program.clear();
+        CHECK(!parseProgramText("PRINT('open\nDECLARE(x, 1)\n", program, error));
+    }
+
+    // Writes each (name, text) as <dir>/<name>.txt in a fresh directory
+    std::filesystem::path programDirectory(const char* dirName, std::initializer_list<std::pair<const char*, const char*>> files) {
+        const std::filesystem::path dir = std::filesystem::temp_directory_path() / dirName;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        for (const auto& [name, text] : files) std::ofstream(dir / (std::string(name) + ".txt")) << text;
+        return dir;
+    }
+
+    // Files with the same text are parsed once, and their processes run one program image
+    void loadedProgramsShared() {
+        TestSystem t;
+        const std::filesystem::path dir = programDirectory("csopesy_test_programs", {
+            { "a", "DECLARE(x, 1)\nPRINT('x=' + x)\n" },
+            { "b", "DECLARE(x, 1)\nPRINT('x=' + x)\n" },
+            { "c", "DECLARE(x, 2)\nPRINT('x=' + x)\n" },
+        });
+        ThreadPool pool(2);
+        std::vector<LoadedProgram> loaded = loadProgramsParallel(
+            { (dir / "a.txt").string(), (dir / "b.txt").string(), (dir / "c.txt").string() }, pool);
+        CHECK(loaded.size() == 3 && loaded[0].instructions.size() == 2 && loaded[2].instructions.size() == 2);
+        if (loaded.size() == 3 && loaded[0].instructions.size() == 2 && loaded[2].instructions.size() == 2) {
+            CHECK(loaded[0].instructions[0] == loaded[1].instructions[0]);
+            CHECK(loaded[0].instructions[0] != loaded[2].instructions[0]);
+        }
+
+        Session session;
+        std::ostringstream out;
+        CHECK(executeCommand(session, "load-dir " + dir.string() + " 64", out) == CommandStatus::OK);
+        const Process* a = t.sim.processTable.get(findProcess("a"));
+        const Process* b = t.sim.processTable.get(findProcess("b"));
+        const Process* c = t.sim.processTable.get(findProcess("c"));
+        CHECK(a != nullptr && b != nullptr && c != nullptr);
+        if (a && b && c) {
+            CHECK(a->program == b->program);
+            CHECK(a->program != c->program);
+            CHECK(a->instructionCount() == 2 && c->instructionCount() == 2);
+        }
+        std::filesystem::remove_all(dir);
+    }
+
+    // The compiled cache serves the second load; copies of one text still share what it
+    // returned, and it builds the same program the parser did
+    void programCacheServesLoads() {
+        const std::filesystem::path dir = programDirectory("csopesy_test_cached", {
+            { "a", "DECLARE(x, 1)\nFOR([ADD(x, x, 1)], 3)\nPRINT('x=' + x)\n" },
+            { "b", "DECLARE(x, 1)\nFOR([ADD(x, x, 1)], 3)\nPRINT('x=' + x)\n" },
+            { "c", "WRITE(0x20, 5)\n" },
+        });
+        const std::filesystem::path cache = std::filesystem::temp_directory_path() / "csopesy_test_cache";
+        std::filesystem::remove_all(cache);
+        std::filesystem::create_directories(cache);
+        const std::vector<std::string> paths = { (dir / "a.txt").string(), (dir / "b.txt").string(), (dir / "c.txt").string() };
+        ThreadPool pool(2);
+
+        std::vector<LoadedProgram> parsed = loadProgramsParallel(paths, pool, cache.string());
+        CHECK(!parsed[0].cached && !parsed[1].cached && !parsed[2].cached);
+        CHECK(std::distance(std::filesystem::directory_iterator(cache), std::filesystem::directory_iterator()) == 2);
+
+        std::vector<LoadedProgram> cached = loadProgramsParallel(paths, pool, cache.string());
+        CHECK((cached[0].cached || cached[1].cached) && cached[2].cached);
+        CHECK(cached[0].instructions.size() == 3 && cached[1].instructions.size() == 3);
+        if (cached[0].instructions.size() == 3 && cached[1].instructions.size() == 3) {
+            CHECK(cached[0].instructions[0] == cached[1].instructions[0]);
+            for (size_t i = 0; i < 3; ++i) CHECK(cached[0].instructions[i]->toString() == parsed[0].instructions[i]->toString());
+        }
+        std::filesystem::remove_all(cache);
+        std::filesystem::remove_all(dir);
+    }
+
+    // === Record / replay ===
+    // A recorded session replays to the same digest; a recording cut off mid-line is
+    // reported, not thrown out of the parser
+    void recordingReplays() {
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "csopesy_test.rec";
+        {
+            TestSystem t;
+            std::ostringstream out;
+            Session session;
+            CHECK(executeCommand(session, "record " + file.string(), out) == CommandStatus::OK);
+            executeCommand(session, "screen -c p1 64 \"DECLARE(x, 1); ADD(x, x, 2); PRINT('x=' + x)\"", out);
+            executeCommand(session, "exit", out);
+            for (int tick = 0; tick < 2; ++tick) scheduler_loop_tick(true);
+            executeCommand(session, "screen -c p2 64 \"WRITE(0x10, 7); READ(y, 0x10)\"", out);
+            executeCommand(session, "exit", out);
+            t.runToCompletion();
+            executeCommand(session, "record stop", out);
+        }
+        std::ostringstream result;
+        std::streambuf* stdoutBuf = std::cout.rdbuf(result.rdbuf());
+        const int status = runReplay(file.string());
+        std::cout.rdbuf(stdoutBuf);
+        CHECK(status == 0);
+        CHECK(result.str().find("\"match\":true") != std::string::npos);
+
+        std::ifstream in(file);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        CHECK(text.find("\nend ") != std::string::npos);
+        {
+            std::ofstream out(file, std::ios::trunc);
+            out << text.substr(0, text.find("\nend ")) << "\nend 1"; // cut off before the digest
+        }
+        std::streambuf* stderrBuf = std::cerr.rdbuf(result.rdbuf());
+        const int truncated = runReplay(file.string());
+        std::cerr.rdbuf(stderrBuf);
+        CHECK(truncated == 1);
+        CHECK(result.str().find("malformed 'end' entry") != std::string::npos);
+        std::filesystem::remove(file);
+    }
+
+    // === Checkpoint / restore ===
+    // A snapshot taken mid-run restores to the same digest on another instance, and both
+    // instances then finish the same way
+    void snapshotRestoresState() {
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "csopesy_test.snap";
+        TestSystem original;
+        for (int i = 0; i < 6; ++i) {
+            const std::string name = "p" + std::to_string(i);
+            CHECK(original.create(name, { "DECLARE(x, 3)", "WRITE(0x30, x)", "ADD(x, x, 4)", "WRITE(0x20, x)",
+                "READ(y, 0x30)", "PRINT('y=' + y)" }) > 0);
+        }
+        for (int tick = 0; tick < 9; ++tick) scheduler_loop_tick(true);
+        std::string error;
+        CHECK(saveSnapshot(file.string(), error));
+        const uint64_t saved = stateDigest(original.sim);
+
+        TestSystem restored(ConfigOverrides{ { "num-cpu", "2" } });
+        CHECK(loadSnapshot(file.string(), error));
+        CHECK(error.empty());
+        CHECK(stateDigest(restored.sim) == saved);
+        CHECK(restored.sim.cpuCores.size() == 1);
+
+        restored.runToCompletion();
+        const uint64_t restoredEnd = stateDigest(restored.sim);
+        {
+            EmulatorBinding rebind(original.sim);
+            original.runToCompletion();
+            CHECK(stateDigest(original.sim) == restoredEnd);
+        }
+        std::filesystem::remove(file);
+    }
+
+    // === Process table ===
+    void processTableSlotReuse() {
+        ProcessTable table;
+        Process first(table.resource());
+        first.pid = 1;
+        ProcessHandle stale = table.insert(std::move(first));
+        CHECK(table.erase(stale));
+        CHECK(table.get(stale) == nullptr);
+
+        Process second(table.resource());
+        second.pid = 2;
+        ProcessHandle fresh = table.insert(std::move(second));
+        CHECK(fresh.index == stale.index);
+        CHECK(fresh.generation != stale.generation);
+        CHECK(table.get(stale) == nullptr);
+        CHECK(!table.erase(stale));
+        CHECK(table.get(fresh) != nullptr && table.get(fresh)->pid == 2);
+        CHECK(!table.find(1));
+
+        // Clearing the table (initialize, restore) must not let an old handle alias the
+        // process that next lands in its slot
+        table.clear();
+        Process third(table.resource());
+        third.pid = 3;
+        ProcessHandle afterClear = table.insert(std::move(third));
+        CHECK(afterClear.index == fresh.index);
+        CHECK(table.get(fresh) == nullptr && table.get(stale) == nullptr);
+        CHECK(table.get(afterClear) != nullptr && table.get(afterClear)->pid == 3);
+    }
+
+    // Once the pool is warm, a process's page table and logs come out of blocks the last
+    // retired process handed back: a cycle with them allocates no more than one without
+    void processPoolRecycles() {
+        ProcessTable table;
+        auto cycle = [&](int pid, int logLines) {
+            Process p(table.resource());
+            p.pid = pid;
+            for (int page = 0; page < 16; ++page) p.page_table[page] = PageTableEntry();
+            for (int i = 0; i < logLines; ++i) p.logs.emplace_back("Value of sum: a line past the short-string buffer");
+            table.erase(table.insert(std::move(p)));
+        };
+        cycle(1, 0);
+        cycle(2, 32);
+
+        unsigned long long before = allocCount.load();
+        cycle(3, 0);
+        const unsigned long long bare = allocCount.load() - before; // the pid index node
+        before = allocCount.load();
+        for (int pid = 4; pid < 100; ++pid) cycle(pid, 32);
+        CHECK(allocCount.load() - before == bare * 96);
+    }
+
+    // Counts what the pool asks of the default resource it was built on
+    struct CountingResource : std::pmr::memory_resource {
+        unsigned long long allocations = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    // The same, through the scheduler: each process that runs and retires hands its page
+    // table back, so once the pool is warm more processes take nothing new from upstream.
+    // The logs go with the finished record, still on the table's pool.
+    void processPoolRecyclesThroughScheduler() {
+        CountingResource upstream;
+        std::pmr::memory_resource* previous = std::pmr::set_default_resource(&upstream);
+        {
+            TestSystem t;
+            auto run = [&](int i) {
+                CHECK(t.create("p" + std::to_string(i), { "WRITE(0x10, 1)", "WRITE(0x20, 2)", "WRITE(0x30, 3)" }) > 0);
+                t.runToCompletion();
+            };
+            run(0);
+            run(1);
+            const unsigned long long before = upstream.allocations;
+            for (int i = 2; i < 40; ++i) run(i);
+            CHECK(before > 0 && upstream.allocations == before);
+
+            CHECK(t.create("logger", { "DECLARE(x, 7)", "PRINT('x is ' + x)" }) > 0);
+            t.runToCompletion();
+            const FinishedProcess* done = findFinishedProcess("logger");
+            CHECK(done != nullptr && done->logs.size() == 1);
+            CHECK(done != nullptr && done->logs.get_allocator().resource() == t.sim.processTable.resource());
+            CHECK(done != nullptr && done->instructionCount() == 2 && done->symbol_table.size() == 1);
+        }
+        std::pmr::set_default_resource(previous);
+    }
+
+    void finishedProcessRetired() {
+        TestSystem t;
+        CHECK(t.create("p1", { "DECLARE(x, 5)", "WRITE(0x20, x)" }) > 0);
+        const ProcessHandle handle = findProcess("p1");
+        t.runToCompletion();
+
+        // Out of the table, memory handed back, still listed by name
+        CHECK(t.sim.processTable.empty());
+        CHECK(t.sim.processTable.get(handle) == nullptr);
+        CHECK(t.sim.memoryManager->getFreeFrameCount() == t.sim.memoryManager->getTotalFrames());
+        CHECK(t.sim.memoryManager->backing_store.empty());
+        const FinishedProcess* done = findFinishedProcess("p1");
+        CHECK(done != nullptr && done->state() == ProcessState::FINISHED && done->pc == 2);
+        CHECK(t.create("p1", { "DECLARE(y, 1)" }) < 0);
+
+        // The next process takes the retired slot; the old handle must not resolve to it
+        CHECK(t.create("p2", { "DECLARE(y, 1)" }) > 0);
+        CHECK(findProcess("p2").index == handle.index);
+        CHECK(t.sim.processTable.get(handle) == nullptr);
+    }
+
+    // Retiring one process leaves every other process's frames and backing-store pages
+    // alone, and the finished list keeps its counts by end state
+    void retirementKeepsOthersPages() {
+        TestSystem t(ConfigOverrides{ { "num-cpu", "2" } });
+        CHECK(t.create("short", { "WRITE(0x20, 1)" }) > 0);
+        CHECK(t.create("long", { "WRITE(0x30, 2)", "SLEEP(20)", "READ(v, 0x30)" }) > 0);
+        for (int tick = 0; tick < 3; ++tick) scheduler_loop_tick(true);
+
+        CHECK(findFinishedProcess("short") != nullptr);
+        const Process* running = t.sim.processTable.get(findProcess("long"));
+        CHECK(running != nullptr);
+        const int pid = running ? running->pid : -1;
+        CHECK(t.sim.memoryManager->backing_store.count(std::to_string(pid) + ":3") == 1);
+        CHECK(t.sim.memoryManager->isPageResident(pid, 0x30));
+        CHECK(t.sim.finishedProcesses.finishedCount() == 1 && t.sim.finishedProcesses.violatedCount() == 0);
+
+        t.runToCompletion();
+        CHECK(t.sim.memoryManager->backing_store.empty());
+        CHECK(t.sim.finishedProcesses.finishedCount() == 2);
+    }
+
+    // A 33rd variable does not fit in page 0: the process ends on a memory violation at
+    // that instruction instead of carrying on without it
+    void symbolOverflowViolates() {
+        TestSystem t;
+        std::vector<std::shared_ptr<Instruction>> program;
+        for (size_t i = 0; i <= SymbolTable::CAPACITY; ++i) program.push_back(parseInstruction("DECLARE(v" + std::to_string(i) + ", 1)"));
+        program.push_back(parseInstruction("DECLARE(v0, 2)"));
+        CHECK(createProcess("p", 64, std::move(program)) > 0);
+        t.runToCompletion();
+
+        const FinishedProcess* done = findFinishedProcess("p");
+        CHECK(done != nullptr && done->state() == ProcessState::MEMORY_VIOLATED);
+        CHECK(done != nullptr && done->pc == static_cast<int>(SymbolTable::CAPACITY));
+        CHECK(done != nullptr && done->symbol_table.size() == SymbolTable::CAPACITY && done->logs.size() == 1);
+        CHECK(t.sim.finishedProcesses.violatedCount() == 1);
+    }
+
+    // === Superinstructions ===
+    // Runs a few processes in quantum mode under memory pressure and returns the trace
+    // with its wall-clock stamps cut off, and the final digest
+    std::pair<std::string, uint64_t> quantumRunTrace(bool superinstructions) {
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "csopesy_test_trace.txt";
+        std::filesystem::remove(file);
+        std::string trace;
+        uint64_t digest = 0;
+        {
+            TestSystem t({ { "exec-mode", "quantum" }, { "scheduler", "rr" }, { "quantum-cycles", "5" },
+                { "max-overall-mem", "96" } });
+            t.sim.superinstructions = superinstructions;
+            t.sim.traceEnabled = true;
+            t.sim.tracePath = file.string();
+            for (const char* name : { "a", "b", "c" }) {
+                CHECK(t.create(name, { "DECLARE(x, 1)", "ADD(x, x, 2)", "WRITE(0x20, x)", "READ(y, 0x20)",
+                    "PRINT('y is ' + y)", "SLEEP(1)", "SUBTRACT(x, y, 1)", "WRITE(0x30, x)", "NOP",
+                    "READ(z, 0x30)", "ADD(z, z, y)" }) > 0);
+            }
+            t.runToCompletion();
+            digest = stateDigest(t.sim);
+            t.sim.traceFile.close();
+        }
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) trace += line.substr(line.find("] ") + 2) + "\n";
+        std::filesystem::remove(file);
+        return { trace, digest };
+    }
+
+    // Fusion only changes how instructions are dispatched: the trace and the end state
+    // are the same with it off
+    void superinstructionsInvisible() {
+        const auto fused = quantumRunTrace(true);
+        const auto plain = quantumRunTrace(false);
+        CHECK(!fused.first.empty());
+        CHECK(fused.first == plain.first);
+        CHECK(fused.second == plain.second);
+    }
+
+    // === Optimizer ===
+    InstructionList parseProgram(std::initializer_list<const char*> lines) {
+        InstructionList program;
+        for (const char* line : lines) program.push_back(parseInstruction(line));
+        return program;
+    }
+
+    std::vector<std::string> programText(const InstructionList& program) {
+        std::vector<std::string> text;
+        for (const auto& instr : program) text.push_back(instr->toString());
+        return text;
+    }
+
+    // Known values fold into literals and constant arithmetic; stores nothing reads again
+    // go, except each variable's first, which holds its symbol-table slot
+    void optimizerFoldsAndDropsDeadStores() {
+        const auto source = { "DECLARE(a, 5)", "ADD(b, a, 3)", "DECLARE(a, 9)", "PRINT('b=' + b)", "ADD(b, b, 1)" };
+
+        InstructionList full = parseProgram(source);
+        OptimizeStats stats = optimizeProgram(full, 0, SymbolTable{}, OptimizeMode::FULL);
+        CHECK(stats.folded == 2 && stats.eliminated == 2 && stats.loops == 0);
+        CHECK(programText(full) == std::vector<std::string>({ "DECLARE(a, 5)", "DECLARE(b, 8)", "PRINT('b=' + 8)" }));
+
+        InstructionList accurate = parseProgram(source);
+        optimizeProgram(accurate, 0, SymbolTable{}, OptimizeMode::TICK_ACCURATE);
+        CHECK(programText(accurate) ==
+            std::vector<std::string>({ "DECLARE(a, 5)", "DECLARE(b, 8)", "NOP", "PRINT('b=' + 8)", "NOP" }));
+
+        // Already declared with unknown values (a running process): nothing to fold
+        SymbolTable declared;
+        declared.declare(internSymbol("a"));
+        InstructionList rest = parseProgram({ "ADD(b, a, 3)", "PRINT('b=' + b)" });
+        stats = optimizeProgram(rest, 0, declared, OptimizeMode::FULL);
+        CHECK(stats.folded == 0 && stats.eliminated == 0);
+        CHECK(programText(rest) == std::vector<std::string>({ "ADD(b, a, 3)", "PRINT('b=' + b)" }));
+    }
+
+    // tick-accurate keeps every tick even when the accesses it drops would have faulted:
+    // the same processes finish at the same ticks, printing the same lines, as unoptimized
+    std::vector<std::string> optimizedRunOutcome(const char* mode) {
+        TestSystem t({ { "optimize", mode }, { "scheduler", "rr" }, { "quantum-cycles", "3" },
+            { "max-overall-mem", "96" } });
+        for (const char* name : { "a", "b", "c" }) {
+            CHECK(t.create(name, { "DECLARE(x, 1)", "WRITE(0x20, 4)", "ADD(y, x, 2)", "DECLARE(x, 3)",
+                "WRITE(0x30, y)", "ADD(y, y, 1)", "READ(z, 0x20)", "PRINT('z=' + z)" }) > 0);
+        }
+        t.runToCompletion();
+        std::vector<std::string> outcome{ std::to_string(t.sim.global_tick) };
+        for (const FinishedProcess& p : t.sim.finishedProcesses) {
+            outcome.push_back(p.name + "@" + std::to_string(p.finish_tick));
+            outcome.insert(outcome.end(), p.logs.begin(), p.logs.end());
+        }
+        return outcome;
+    }
+
+    void optimizerKeepsTicks() {
+        const auto plain = optimizedRunOutcome("off");
+        CHECK(plain.size() == 7);
+        CHECK(optimizedRunOutcome("tick-accurate") == plain);
+    }
+
+    // optimize <process> rewrites the rest of that process's program only
+    void optimizeCommandRewrites() {
+        TestSystem t;
+        CHECK(t.create("p", { "DECLARE(a, 5)", "ADD(b, a, 3)", "DECLARE(a, 9)", "PRINT('b=' + b)", "ADD(b, b, 1)" }) > 0);
+        CHECK(t.create("q", { "DECLARE(a, 5)", "ADD(b, a, 3)", "DECLARE(a, 9)", "PRINT('b=' + b)", "ADD(b, b, 1)" }) > 0);
+        Session session;
+        std::ostringstream out;
+        CHECK(executeCommand(session, "optimize p full", out) == CommandStatus::OK);
+        CHECK(out.str() == "Optimized p from instruction 0: 5 -> 3 instructions (2 folded, 2 dead stores, 0 empty loops).\n");
+        CHECK(t.sim.processTable.get(findProcess("p"))->instructionCount() == 3);
+        CHECK(t.sim.processTable.get(findProcess("q"))->instructionCount() == 5);
+
+        out.str("");
+        CHECK(executeCommand(session, "optimize p fast", out) == CommandStatus::OK);
+        CHECK(out.str().find("Unknown optimize mode 'fast'") != std::string::npos);
+
+        t.runToCompletion();
+        const FinishedProcess* p = findFinishedProcess("p");
+        const FinishedProcess* q = findFinishedProcess("q");
+        CHECK(p != nullptr && q != nullptr && p->logs.size() == 1 && q->logs.size() == 1);
+        CHECK(p != nullptr && q != nullptr && p->logs.front() == q->logs.front());
+    }
+
+    // === Bulk memory ===
+    // A MEMCPY ending the program still costs its pages: two pages at 4 ticks each hold the
+    // core through tick 9 (DECLARE at 1, the copy at 2, then 7 more), in either exec-mode
+    void bulkTransferChargedAtEnd() {
+        for (const char* mode : { "tick", "quantum" }) {
+            TestSystem t({ { "bulk-page-ticks", "4" }, { "exec-mode", mode }, { "quantum-cycles", "3" } });
+            CHECK(t.create("p", { "DECLARE(x, 5)", "MEMCPY(0x20, 0x0, 16)" }) > 0);
+            t.runToCompletion();
+
+            const FinishedProcess* done = findFinishedProcess("p");
+            CHECK(done != nullptr && done->state() == ProcessState::FINISHED);
+            CHECK(done != nullptr && done->finish_tick == 9 && done->busy_ticks == 0);
+            CHECK(t.sim.global_tick == 9);
+            CHECK(t.sim.busyCoreTicks == 9);
+            CHECK(t.sim.instructionsExecuted == 2);
+        }
+    }
+
+    // === Console output ===
+    // A command's output goes to the stream it was given; other threads, such as the
+    // scheduler, keep printing to stdout and never land in that stream
+    void commandOutputToStream() {
+        TestSystem t;
+        CHECK(t.create("p1", { "DECLARE(x, 5)" }) > 0);
+        std::streambuf* const stdoutBuf = std::cout.rdbuf();
+        std::ostringstream captured;
+        std::ostream* otherThread = nullptr;
+        {
+            ConsoleOutput output(captured);
+            std::thread([&] { otherThread = &consoleOut(); }).join();
+        }
+        CHECK(otherThread == &std::cout);
+
+        Session session;
+        CHECK(executeCommand(session, "screen -ls", captured) == CommandStatus::OK);
+        CHECK(captured.str().find("p1") != std::string::npos);
+        CHECK(&consoleOut() == &std::cout);
+        CHECK(std::cout.rdbuf() == stdoutBuf);
+    }
+
+    // === Config overrides ===
+    // Overrides (one sweep run's settings) are checked, never "repaired": a bad one fails the
+    // load and leaves the config file as it was
+    void configOverridesValidated() {
+        Emulator sim;
+        EmulatorBinding bind(sim);
+        std::ostringstream messages;
+        ConsoleOutput quiet(messages);
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "csopesy_test_config.txt";
+        {
+            std::ofstream out(file);
+            out << "num-cpu 2\nscheduler fcfs\n";
+        }
+
+        CHECK(loadConfigFile(file.string(), { { "num-cpu", "3" } }));
+        CHECK(sim.systemConfig.num_cpu == 3);
+        CHECK(!loadConfigFile(file.string(), { { "num-cpu", "0" } }));
+        CHECK(!loadConfigFile(file.string(), { { "num-cpus", "2" } }));
+        CHECK(!loadConfigFile(file.string(), { { "quantum-cycles", "x" } }));
+        CHECK(messages.str().find("Regenerating") == std::string::npos);
+        std::ifstream in(file);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        CHECK(text == "num-cpu 2\nscheduler fcfs\n");
+        in.close();
+        std::filesystem::remove(file);
+
+        CHECK(!loadConfigFile(file.string(), { { "num-cpu", "1" } }));
+        CHECK(!std::filesystem::exists(file));
+    }
+
+    const struct {
+        const char* name;
+        void (*run)();
+    } tests[] = {
+        { "seeded-runs-repeat", seededRunsRepeat },
+        { "program-text-parses", programTextParses },
+        { "loaded-programs-shared", loadedProgramsShared },
+        { "program-cache-serves-loads", programCacheServesLoads },
+        { "recording-replays", recordingReplays },
+        { "snapshot-restores-state", snapshotRestoresState },
+        { "process-table-slot-reuse", processTableSlotReuse },
+        { "process-pool-recycles", processPoolRecycles },
+        { "process-pool-recycles-through-scheduler", processPoolRecyclesThroughScheduler },
+        { "finished-process-retired", finishedProcessRetired },
+        { "retirement-keeps-others-pages", retirementKeepsOthersPages },
+        { "symbol-overflow-violates", symbolOverflowViolates },
+        { "superinstructions-invisible", superinstructionsInvisible },
+        { "optimizer-folds-and-drops-dead-stores", optimizerFoldsAndDropsDeadStores },
+        { "optimizer-keeps-ticks", optimizerKeepsTicks },
+        { "optimize-command-rewrites", optimizeCommandRewrites },
+        { "bulk-transfer-charged-at-end", bulkTransferChargedAtEnd },
+        { "command-output-to-stream", commandOutputToStream },
+        { "config-overrides-validated", configOverridesValidated },
+    };
+}
+
+int main(int argc, char* argv[]) {
+    bool ran = false;
+    for (const auto& test : tests) {
+        if (argc > 1 && std::strcmp(argv[1], test.name) != 0) continue;
+        const int before = failures;
+        test.run();
+        std::cerr << (failures == before ? "PASS " : "FAIL ") << test.name << "\n";
+        ran = true;
+    }
+    if (!ran) {
+        std::cerr << "Unknown test " << argv[1] << "\n";
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}